@@ -0,0 +1,56 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+
+namespace esd::wnd::bench {
+
+// Keeps the optimizer from dropping work whose result isn't otherwise used
+template <typename T>
+inline void keep(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Run fn repeatedly for at least minTime, returning nanoseconds per call
+// The best of a few rounds is taken, since anything else running only ever
+// makes a round slower
+template <typename F>
+double measure(F&& fn, std::chrono::milliseconds minTime = std::chrono::milliseconds(200)) {
+    using Clock = std::chrono::steady_clock;
+    double best = 0;
+    for (int round = 0; round < 5; round++) {
+        long long calls = 0;
+        auto start = Clock::now();
+        auto end = start;
+        while (end - start < minTime / 5) {
+            for (int i = 0; i < 16; i++) fn();
+            calls += 16;
+            end = Clock::now();
+        }
+        double ns = std::chrono::duration<double, std::nano>(end - start).count() / calls;
+        if (round == 0 || ns < best) best = ns;
+    }
+    return best;
+}
+
+}
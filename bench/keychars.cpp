@@ -0,0 +1,126 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+// Characters per second through keyCharHandler, translating key presses with
+// the key table and with XIM (XFilterEvent and Xutf8LookupString)
+// Needs an X server, e.g. run through xvfb-run
+
+#include "bench.hpp"
+#include "impl.hpp"
+#include <X11/Xutil.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <vector>
+
+using namespace esd::wnd;
+
+namespace {
+
+class BenchWindow : public esd::wnd::Window {
+public:
+    using esd::wnd::Window::Window;
+
+    // Translate through XIM even though no input method is attached, which
+    // is the path every key press took before the key table
+    void setXimTranslation(bool xim) { impl->hasInputMethod = xim; }
+
+    Display* getDisplay() { return impl->display; }
+    ::Window getXWindow() { return impl->window; }
+};
+
+// Key presses typing the text, upper case letters with Shift
+std::vector<XEvent> makeKeyPresses(BenchWindow& window, std::string_view text) {
+    std::vector<XEvent> events;
+    for (char c : text) {
+        KeySym keySym = c == ' ' ? XK_space : c == '.' ? XK_period : static_cast<KeySym>(c);
+        KeySym lower, upper;
+        XConvertCase(keySym, &lower, &upper);
+
+        XEvent xe = {};
+        xe.xkey.type = KeyPress;
+        xe.xkey.display = window.getDisplay();
+        xe.xkey.window = window.getXWindow();
+        xe.xkey.keycode = XKeysymToKeycode(window.getDisplay(), lower);
+        xe.xkey.state = keySym != lower ? ShiftMask : 0;
+        xe.xkey.same_screen = True;
+        events.push_back(xe);
+    }
+    return events;
+}
+
+double measureCharsPerSecond(BenchWindow& window, const std::vector<XEvent>& keyPresses, std::size_t& typed) {
+    using Clock = std::chrono::steady_clock;
+    constexpr int batches = 200;
+
+    double best = 0;
+    for (int round = 0; round < 5; round++) {
+        typed = 0;
+        Clock::duration total = {};
+        for (int batch = 0; batch < batches; batch++) {
+            // Put back events are read before anything from the server, so
+            // they go in reverse
+            for (auto it = keyPresses.rbegin(); it != keyPresses.rend(); it++) {
+                XEvent xe = *it;
+                XPutBackEvent(window.getDisplay(), &xe);
+            }
+
+            auto start = Clock::now();
+            window.poll();
+            total += Clock::now() - start;
+        }
+        double rate = typed / std::chrono::duration<double>(total).count();
+        if (rate > best) best = rate;
+    }
+    return best;
+}
+
+}
+
+int main() {
+    if (!std::getenv("DISPLAY")) {
+        std::printf("Needs an X server, e.g. xvfb-run %s\n", "eseed_window_bench_keychars");
+        return 0;
+    }
+
+    BenchWindow window("Key chars", { 320, 240 });
+    window.poll();
+
+    std::size_t typed = 0;
+    window.setKeyCharHandler([&](KeyCharEvent e) { typed++; });
+
+    std::string text;
+    for (int i = 0; i < 16; i++) text += "The quick brown fox jumps over the lazy dog. ";
+    auto keyPresses = makeKeyPresses(window, text);
+
+    window.setXimTranslation(false);
+    double table = measureCharsPerSecond(window, keyPresses, typed);
+    std::size_t tableTyped = typed;
+
+    window.setXimTranslation(true);
+    double xim = measureCharsPerSecond(window, keyPresses, typed);
+
+    if (typed != tableTyped) std::printf("Warning: the modes typed %zu and %zu chars\n", tableTyped, typed);
+    std::printf("%zu key presses per poll\n", keyPresses.size());
+    std::printf("key table:  %12.0f chars/s\n", table);
+    std::printf("XIM:        %12.0f chars/s\n", xim);
+    std::printf("speedup:    %12.1fx\n", table / xim);
+}
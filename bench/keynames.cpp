@@ -0,0 +1,74 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+// Cost of resolving a keyboard's XKB key names when a window is created, with
+// the perfect hash against the strncmp scan over every mapping it replaced
+
+#include "bench.hpp"
+#include "inputmappings.hpp"
+#include <array>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace esd::wnd;
+
+namespace {
+
+// The scan initKeyTables() used to do for each key code
+Key findByScan(const char* name) {
+    for (const auto& mapping : keyMappings) {
+        if (std::strncmp(name, mapping.name, XkbKeyNameLength) == 0) return mapping.key;
+    }
+    return Key::Unknown;
+}
+
+}
+
+int main() {
+    // A typical evdev keymap: the mapped keys plus names like I120 that don't
+    // map to anything, 248 key codes in all as with min 8 and max 255
+    std::vector<std::string> names;
+    for (const auto& mapping : keyMappings) names.push_back(mapping.name);
+    for (int i = 0; names.size() < 248; i++) names.push_back("I" + std::to_string(120 + i));
+
+    // Names in the XKB map aren't null terminated when they use all 4 chars
+    std::vector<std::array<char, XkbKeyNameLength>> keyNames(names.size());
+    for (std::size_t i = 0; i < names.size(); i++) std::strncpy(keyNames[i].data(), names[i].c_str(), XkbKeyNameLength);
+
+    for (const auto& name : keyNames) {
+        if (xkbKeyNameTable.find(name.data()) != findByScan(name.data())) {
+            std::printf("Mismatch for %.4s\n", name.data());
+            return 1;
+        }
+    }
+
+    double scan = bench::measure([&] {
+        for (const auto& name : keyNames) bench::keep(findByScan(name.data()));
+    });
+    double hash = bench::measure([&] {
+        for (const auto& name : keyNames) bench::keep(xkbKeyNameTable.find(name.data()));
+    });
+
+    std::printf("%zu key codes against %zu mappings\n", keyNames.size(), std::size(keyMappings));
+    std::printf("strncmp scan:  %10.1f ns per keymap\n", scan);
+    std::printf("perfect hash:  %10.1f ns per keymap\n", hash);
+    std::printf("speedup:       %10.1fx\n", scan / hash);
+}
@@ -0,0 +1,125 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+// Startup cost of a full-size gamecontrollerdb.txt: loading and indexing it
+// and looking up the pads that connect, with the memory-mapped index against
+// a line by line iostream parse into a map, as SDL-style loaders do
+
+#include "bench.hpp"
+#include "mappingdb.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace esd::wnd;
+
+namespace {
+
+// Entries per platform, about the size of the current upstream database
+constexpr int entriesPerPlatform = 2000;
+
+std::string makeGuid(int bus, int vendor, int product, int version) {
+    char guid[33];
+    std::snprintf(guid, sizeof(guid), "%02x%02x0000%02x%02x0000%02x%02x0000%02x%02x0000", 
+        bus & 0xFF, bus >> 8, vendor & 0xFF, vendor >> 8 & 0xFF, 
+        product & 0xFF, product >> 8 & 0xFF, version & 0xFF, version >> 8 & 0xFF);
+    return guid;
+}
+
+std::string makeGuid(int entry) {
+    return makeGuid(3, 0x045E + entry % 97, 0x0200 + entry, 0x0100 + entry % 7);
+}
+
+// Lines in the upstream format, with comments per section and every GUID once
+// per platform
+void writeDatabase(const std::string& path) {
+    std::ofstream out(path);
+    out << "# Game Controller DB for SDL in 2.0.16 format\n";
+    for (const char* platform : { "Windows", "Mac OS X", "Linux", "Android", "iOS" }) {
+        out << "\n# " << platform << "\n";
+        for (int entry = 0; entry < entriesPerPlatform; entry++) {
+            out << makeGuid(entry) << ",Generic Controller " << entry 
+                << ",a:b0,b:b1,back:b6,dpdown:h0.4,dpleft:h0.8,dpright:h0.2,dpup:h0.1,guide:b8,"
+                << "leftshoulder:b4,leftstick:b9,lefttrigger:a2,leftx:a0,lefty:a1,rightshoulder:b5,"
+                << "rightstick:b10,righttrigger:a5,rightx:a3,righty:a4,start:b7,x:b2,y:b3,"
+                << "platform:" << platform << ",\n";
+        }
+    }
+}
+
+// Everything parsed up front, keeping the last entry for this platform
+std::unordered_map<std::string, std::string> parseWithStreams(const std::string& path) {
+    std::unordered_map<std::string, std::string> mappings;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::size_t guidEnd = line.find(',');
+        std::size_t nameEnd = line.find(',', guidEnd + 1);
+        if (guidEnd != 32 || nameEnd == std::string::npos) continue;
+        if (line.find("platform:Linux,") == std::string::npos) continue;
+        mappings[line.substr(0, guidEnd)] = line.substr(nameEnd + 1);
+    }
+    return mappings;
+}
+
+}
+
+int main() {
+    std::string path = (std::filesystem::temp_directory_path() / "eseed_window_bench_mappingdb.txt").string();
+    writeDatabase(path);
+
+    // A few pads connecting, one of them without an entry
+    std::vector<std::string> guids = { makeGuid(7), makeGuid(1234), makeGuid(1999), makeGuid(3, 0x1234, 0x5678, 1) };
+
+    GamepadMappingDb db;
+    db.load(path);
+    auto streamed = parseWithStreams(path);
+    for (const auto& guid : guids) {
+        auto it = streamed.find(guid);
+        std::string_view expected = it == streamed.end() ? std::string_view() : std::string_view(it->second);
+        if (db.find(guid) != expected) {
+            std::printf("Mismatch for %s\n", guid.c_str());
+            return 1;
+        }
+    }
+
+    double stream = bench::measure([&] {
+        auto mappings = parseWithStreams(path);
+        for (const auto& guid : guids) bench::keep(mappings.find(guid) != mappings.end());
+    }, std::chrono::milliseconds(2000));
+    double mapped = bench::measure([&] {
+        GamepadMappingDb db;
+        db.load(path);
+        for (const auto& guid : guids) bench::keep(db.find(guid).size());
+    }, std::chrono::milliseconds(2000));
+
+    std::printf("%d entries, %ju bytes, %zu lookups\n", entriesPerPlatform * 5, 
+        static_cast<std::uintmax_t>(std::filesystem::file_size(path)), guids.size());
+    std::printf("iostream parse:  %10.3f ms\n", stream / 1e6);
+    std::printf("mapped index:    %10.3f ms\n", mapped / 1e6);
+    std::printf("speedup:         %10.1fx\n", stream / mapped);
+
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,108 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+// Throughput of convertPixels() for every supported pair of formats, with and
+// without sRGB encoding, for each instruction set this machine can run
+// GB/s counts the bytes read from the source, over a 1080p frame
+
+#include "bench.hpp"
+#include "simd.hpp"
+#include <eseed/window/pixels.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+using namespace esd::wnd;
+
+namespace {
+
+constexpr int width = 1920;
+constexpr int height = 1080;
+
+struct Format { PixelFormat format; const char* name; };
+
+constexpr Format sources[] = {
+    { PixelFormat::Rgba8888, "Rgba8888" },
+    { PixelFormat::Bgra8888, "Bgra8888" },
+    { PixelFormat::Rgba16f, "Rgba16f" }
+};
+
+constexpr Format destinations[] = {
+    { PixelFormat::Bgrx8888, "Bgrx8888" },
+    { PixelFormat::Rgbx8888, "Rgbx8888" },
+    { PixelFormat::Xrgb8888, "Xrgb8888" },
+    { PixelFormat::Xbgr8888, "Xbgr8888" },
+    { PixelFormat::Rgb565, "Rgb565" },
+    { PixelFormat::Xrgb2101010, "Xrgb2101010" }
+};
+
+struct IsaName { Isa isa; const char* name; };
+
+constexpr IsaName isas[] = {
+    { Isa::Scalar, "Scalar" },
+    { Isa::Sse2, "SSE2" },
+    { Isa::Avx2, "AVX2" },
+    { Isa::Neon, "NEON" }
+};
+
+double measureGbps(const Format& from, const Format& to, bool srgb) {
+    std::vector<std::uint8_t> in(std::size_t(width) * height * getBytesPerPixel(from.format));
+    std::vector<std::uint8_t> out(std::size_t(width) * height * getBytesPerPixel(to.format));
+
+    // Half floats in 0 to 1 (below 0x3C00) and any bytes are in range
+    for (std::size_t i = 0; i < in.size(); i++) in[i] = static_cast<std::uint8_t>(i * 7 % 0x3B);
+
+    PixelBuffer source = { in.data(), width * getBytesPerPixel(from.format), width, height, from.format };
+    PixelBuffer destination = { out.data(), width * getBytesPerPixel(to.format), width, height, to.format };
+    double ns = bench::measure([&] {
+        convertPixels(source, destination, srgb);
+        bench::keep(out[0]);
+    });
+    return in.size() / ns;
+}
+
+}
+
+int main() {
+    std::vector<IsaName> supported;
+    for (const auto& isa : isas) {
+        if (setIsa(isa.isa)) supported.push_back(isa);
+    }
+
+    std::printf("%-28s", "GB/s");
+    for (const auto& isa : supported) std::printf("%10s", isa.name);
+    std::printf("\n");
+
+    for (const auto& from : sources) {
+        for (const auto& to : destinations) {
+            for (bool srgb : { false, true }) {
+                char name[64];
+                std::snprintf(name, sizeof(name), "%s > %s%s", from.name, to.name, srgb ? " sRGB" : "");
+                std::printf("%-28s", name);
+                for (const auto& isa : supported) {
+                    setIsa(isa.isa);
+                    std::printf("%10.2f", measureGbps(from, to, srgb));
+                    std::fflush(stdout);
+                }
+                std::printf("\n");
+            }
+        }
+    }
+}
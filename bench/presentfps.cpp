@@ -0,0 +1,88 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+// Frames per second of software rendering at 1080p and 4K, presenting
+// through MIT-SHM and through XPutImage
+// Needs an X server with a screen of at least 3840x2160, e.g. 
+// xvfb-run -s "-screen 0 3840x2160x24"
+
+#include "bench.hpp"
+#include "impl.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace esd::wnd;
+
+namespace {
+
+class BenchWindow : public esd::wnd::Window {
+public:
+    using esd::wnd::Window::Window;
+
+    // Present through client images copied over the connection, as servers
+    // without MIT-SHM do
+    void disableShm() {
+        getPixelBuffer();
+        impl->present.destroyImage();
+        impl->present.shmAvailable = false;
+    }
+
+    Display* getDisplay() { return impl->display; }
+};
+
+// Every frame is filled with a new color, presented, and waited for until the
+// server has read it
+double measureFps(int width, int height, bool shm) {
+    BenchWindow window("Present FPS", { width, height });
+    if (!shm) window.disableShm();
+    window.poll();
+
+    std::uint32_t color = 0;
+    double ns = bench::measure([&] {
+        PixelBuffer buffer = window.getPixelBuffer();
+        std::size_t rowPixels = buffer.stride / getBytesPerPixel(buffer.format);
+        auto pixels = static_cast<std::uint32_t*>(buffer.data);
+        if (getBytesPerPixel(buffer.format) == 4) {
+            std::fill(pixels, pixels + rowPixels * buffer.height, color += 0x010101);
+        }
+        window.presentPixelBuffer();
+        XSync(window.getDisplay(), False);
+        window.poll();
+    }, std::chrono::milliseconds(2000));
+    return 1e9 / ns;
+}
+
+}
+
+int main() {
+    if (!std::getenv("DISPLAY")) {
+        std::printf("Needs an X server, e.g. xvfb-run -s \"-screen 0 3840x2160x24\" %s\n", "eseed_window_bench_presentfps");
+        return 0;
+    }
+
+    struct Size { const char* name; int width, height; };
+    for (Size size : { Size{ "1080p", 1920, 1080 }, Size{ "4K", 3840, 2160 } }) {
+        double shm = measureFps(size.width, size.height, true);
+        double put = measureFps(size.width, size.height, false);
+        std::printf("%-6s MIT-SHM: %8.1f fps   XPutImage: %8.1f fps\n", size.name, shm, put);
+    }
+}
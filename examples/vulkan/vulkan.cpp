@@ -20,6 +20,7 @@
 
 #include <vulkan/vulkan.hpp>
 #include <eseed/window/vulkanwindow.hpp>
+#include <eseed/window/framepacer.hpp>
 #include <fstream>
 #include <iostream>
 
@@ -376,7 +377,13 @@ int main() {
     // WINDOW LOOP
 
     vk::Queue graphicsQueue = device.getQueue(graphicsQueueFamilyIndex, 0);
-    while (!window.isCloseRequested()) {
+
+    // Frames are paced to the monitor's refresh rate, and the window is polled
+    // right before each one
+    // Where the server reports when presents complete, the swapchain's
+    // presents also align the pacer with the actual vblanks
+    esd::wnd::FramePacer pacer;
+    pacer.run(window, [&](const esd::wnd::FrameInfo& frame) {
 
         // Render
 
@@ -414,11 +421,7 @@ int main() {
         );
 
         graphicsQueue.waitIdle();
-        
-        // Poll for window events
-        
-        window.poll();
-    }
+    });
 
     device.waitIdle();
 
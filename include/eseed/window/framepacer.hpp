@@ -0,0 +1,150 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include <eseed/window/window.hpp>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+namespace esd::wnd {
+
+// Time source the frame pacer measures and waits with, replaceable to
+// simulate time, e.g. to check pacing without a display
+class PacingClock {
+public:
+    virtual ~PacingClock() = default;
+
+    // Monotonic time, by default on the same clock as Present extension
+    // timestamps
+    virtual std::chrono::nanoseconds now() = 0;
+
+    // Sleep for about the duration, possibly waking late
+    virtual void sleep(std::chrono::nanoseconds duration) = 0;
+
+    // Called between checks of now() while spinning for the end of a wait
+    virtual void spin() {}
+};
+
+// std::chrono::steady_clock with thread sleeps
+class SteadyPacingClock : public PacingClock {
+public:
+    std::chrono::nanoseconds now() override;
+    void sleep(std::chrono::nanoseconds duration) override;
+    void spin() override;
+};
+
+struct FrameInfo {
+    std::uint64_t frame; // Numbered from 1
+    std::chrono::nanoseconds time; // When the frame started
+    std::chrono::nanoseconds vblankTime; // Predicted vblank the frame targets
+    double deltaTime; // Seconds since the previous frame started
+    std::uint32_t missedVblanks; // Skipped since the previous frame
+};
+
+// Times are in seconds
+struct FramePacingStats {
+    std::uint64_t frames;
+    std::uint64_t missedVblanks;
+    double period;
+    double averageFrameTime;
+    double frameTimeJitter; // Standard deviation of the frame time
+    double maxFrameTime;
+
+    // How late frames started after the time they were meant to
+    double averageWakeError;
+    double maxWakeError;
+};
+
+// Paces frames to a monitor's refresh rate, starting each one at a phase
+// before the next vblank so it has time to render and present
+// Waits sleep until shortly before the wake time and then spin, since sleeps
+// can wake late by more than the precision pacing needs
+class FramePacer {
+public:
+    FramePacer();
+    explicit FramePacer(PacingClock& clock);
+
+    // In Hz, 0 to use the window's monitor when running, or 60 Hz if that
+    // is unknown too
+    void setRefreshRate(double refreshRate);
+    double getRefreshRate();
+
+    // Fraction of the frame period before the vblank that frames start,
+    // half a period by default
+    void setWakePhase(double phase);
+
+    // How long before the wake time to stop sleeping and spin, 1 ms by
+    // default
+    void setSpinDuration(std::chrono::nanoseconds duration);
+
+    // Align predicted vblanks with a measured one, such as the timestamp of a
+    // present complete event (ust * 1000)
+    void syncVblank(std::chrono::nanoseconds time);
+
+    // Wait for the start of the next frame
+    // Frames that overrun skip to the next vblank that can still be made
+    FrameInfo waitForFrame();
+
+    // Start over after frames stopped for a while, so the gap isn't counted as
+    // one long frame or as missed vblanks
+    void restart();
+
+    // Run frames until the window is asked to close, polling right before
+    // each frame so it sees the latest input
+    // While the window can't be seen, frames stop and events are waited for
+    // Where frame timing is supported, every frame shown in the window
+    // through the Present extension syncs the vblanks, e.g. the presents of a
+    // Vulkan swapchain or of the pixel buffer with frame timing enabled
+    // Running doesn't enable frame timing itself, so the pixel buffer keeps
+    // being presented the way the app chose; without frame timing its
+    // presents don't go through the extension and only the period is tracked
+    // Without any completed presents, the phase is relative to the first
+    // frame instead of the actual vblanks
+    void run(Window& window, std::function<void(const FrameInfo&)> frameHandler);
+
+    FramePacingStats getStats();
+    void resetStats();
+
+private:
+    PacingClock* clock;
+    double refreshRate = 0;
+    double wakePhase = 0.5;
+    std::chrono::nanoseconds spinDuration = std::chrono::milliseconds(1);
+
+    std::chrono::nanoseconds period;
+    std::chrono::nanoseconds vblankAnchor; // Any vblank, the rest follow by period
+    bool anchored = false;
+
+    std::uint64_t frame = 0;
+    bool continuing = false; // Whether the last frame ran right before this one
+    std::chrono::nanoseconds lastTime;
+    std::chrono::nanoseconds lastVblank;
+
+    FramePacingStats stats;
+    std::uint64_t frameTimeCount;
+    double frameTimeMean, frameTimeM2; // Running variance
+    double totalWakeError;
+
+    void setPeriod(double refreshRate);
+};
+
+}
@@ -0,0 +1,129 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace esd::wnd {
+
+// Buttons are named by position, South is A on an Xbox layout and cross on a
+// PlayStation layout
+enum struct GamepadButton {
+    South,
+    East,
+    West,
+    North,
+    LeftBumper,
+    RightBumper,
+    Back,
+    Start,
+    Guide,
+    LeftStick,
+    RightStick,
+    DPadUp,
+    DPadDown,
+    DPadLeft,
+    DPadRight,
+    Count
+};
+
+enum struct GamepadAxis {
+    LeftX,
+    LeftY,
+    RightX,
+    RightY,
+    LeftTrigger,
+    RightTrigger,
+    Count
+};
+
+// State of one pad
+// Sticks are from -1 to 1 (positive is right and down), triggers from 0 to 1
+// and buttons are packed one bit each
+struct GamepadState {
+    float axes[static_cast<std::size_t>(GamepadAxis::Count)];
+    std::uint32_t buttons;
+
+    float getAxis(GamepadAxis axis) const { return axes[static_cast<std::size_t>(axis)]; }
+    bool isButtonDown(GamepadButton button) const { return buttons >> static_cast<int>(button) & 1; }
+};
+
+struct GamepadConnectEvent { int id; bool connected; };
+
+// Every connected gamepad, found when created and kept up to date with
+// hotplugging
+// Can be polled on its own, or attached to a window so it is polled (and
+// waited on) along with the window's events
+class Gamepads {
+public:
+    Gamepads();
+    Gamepads(const Gamepads&) = delete;
+    ~Gamepads();
+
+    // Pads found when created are reported on the first poll
+    void setConnectHandler(std::function<void(GamepadConnectEvent)> handler) { connectHandler = handler; }
+
+    // Read pending input from every pad without blocking
+    void poll();
+
+    // Open a device by path, returning its id
+    // Also accepts files of recorded input events, which are replayed through
+    // poll() as if they came from a pad, e.g. for testing without a controller
+    // Each poll() replays up to and including the next SYN_REPORT
+    int open(const std::string& path);
+
+    // Ids are indices into the state array, and are reused after a pad
+    // disconnects
+    std::size_t getCount();
+    bool isConnected(int id);
+    std::string getName(int id);
+
+    // Identifies the model of a pad, in the format of SDL's mapping database
+    // Empty for recordings
+    std::string getGuid(int id);
+
+    // Load an SDL-style mapping database (gamecontrollerdb.txt) to get the
+    // layout of pads that don't follow the standard one
+    // The file is memory-mapped and only indexed when loaded, and mappings are
+    // only parsed for pads that connect
+    // Replaces any previously loaded database, and remaps connected pads
+    void loadMappings(const std::string& path);
+    const GamepadState& getState(int id);
+
+    // States of every id, getCount() long
+    const GamepadState* getStates();
+
+protected:
+    friend class Window;
+
+    // Should be defined in the platform-specific source file with data members
+    // and additional functions
+    class Impl;
+    std::unique_ptr<Impl> impl;
+
+    std::function<void(GamepadConnectEvent)> connectHandler;
+};
+
+}
@@ -20,7 +20,10 @@
 
 #pragma once
 
-#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
 
 namespace esd::wnd {
 
@@ -200,128 +203,362 @@ enum struct Key {
     LastKey = ScrollLock
 };
 
-inline std::string getKeyName(Key key) {
-    switch (key) {
-    case Key::Backspace: return "Backspace";
-    case Key::Tab: return "Tab";
-    case Key::Return: return "Return";
-    case Key::Escape: return "Escape";
-    case Key::Space: return "Space";
-    case Key::Apostrophe: return "Apostrophe";
-    case Key::Comma: return "Comma";
-    case Key::Dash: return "Dash";
-    case Key::Period: return "Period";
-    case Key::Slash: return "Slash";
-    case Key::Num0: return "0";
-    case Key::Num1: return "1";
-    case Key::Num2: return "2";
-    case Key::Num3: return "3";
-    case Key::Num4: return "4";
-    case Key::Num5: return "5";
-    case Key::Num6: return "6";
-    case Key::Num7: return "7";
-    case Key::Num8: return "8";
-    case Key::Num9: return "9";
-    case Key::Semicolon: return "Semicolon";
-    case Key::Equal: return "Equal";
-    case Key::A: return "A";
-    case Key::B: return "B";
-    case Key::C: return "C";
-    case Key::D: return "D";
-    case Key::E: return "E";
-    case Key::F: return "F";
-    case Key::G: return "G";
-    case Key::H: return "H";
-    case Key::I: return "I";
-    case Key::J: return "J";
-    case Key::K: return "K";
-    case Key::L: return "L";
-    case Key::M: return "M";
-    case Key::N: return "N";
-    case Key::O: return "O";
-    case Key::P: return "P";
-    case Key::Q: return "Q";
-    case Key::R: return "R";
-    case Key::S: return "S";
-    case Key::T: return "T";
-    case Key::U: return "U";
-    case Key::V: return "V";
-    case Key::W: return "W";
-    case Key::X: return "X";
-    case Key::Y: return "Y";
-    case Key::Z: return "Z";
-    case Key::LBracket: return "Left Bracket";
-    case Key::Backslash: return "Backslash";
-    case Key::RBracket: return "Right Bracket";
-    case Key::Backtick: return "Backtick";
-    case Key::Delete: return "Delete";
-    case Key::Clear: return "Clear";
-    case Key::LShift: return "Left Shift";
-    case Key::RShift: return "Right Shift";
-    case Key::LControl: return "Left Control";
-    case Key::RControl: return "Right Control";
-    case Key::LAlt: return "Left Alt";
-    case Key::RAlt: return "Right Alt";
-    case Key::Pause: return "Pause";
-    case Key::CapsLock: return "Caps Lock";
-    case Key::PageUp: return "Page Up";
-    case Key::PageDown: return "Page Down";
-    case Key::End: return "End";
-    case Key::Home: return "Home";
-    case Key::Left: return "Left";
-    case Key::Up: return "Up";
-    case Key::Right: return "Right";
-    case Key::Down: return "Down";
-    case Key::Select: return "Select";
-    case Key::PrintScreen: return "Print Screen";
-    case Key::Insert: return "Insert";
-    case Key::LMeta: return "Left Meta";
-    case Key::RMeta: return "Right Meta";
-    case Key::Menu: return "Menu";
-    case Key::Numpad0: return "Numpad 0";
-    case Key::Numpad1: return "Numpad 1";
-    case Key::Numpad2: return "Numpad 2";
-    case Key::Numpad3: return "Numpad 3";
-    case Key::Numpad4: return "Numpad 4";
-    case Key::Numpad5: return "Numpad 5";
-    case Key::Numpad6: return "Numpad 6";
-    case Key::Numpad7: return "Numpad 7";
-    case Key::Numpad8: return "Numpad 8";
-    case Key::Numpad9: return "Numpad 9";
-    case Key::Multiply: return "Multiply";
-    case Key::Add: return "Add";
-    case Key::Subtract: return "Subtract";
-    case Key::Decimal: return "Decimal";
-    case Key::Divide: return "Divide";
-    case Key::F1: return "F1";
-    case Key::F2: return "F2";
-    case Key::F3: return "F3";
-    case Key::F4: return "F4";
-    case Key::F5: return "F5";
-    case Key::F6: return "F6";
-    case Key::F7: return "F7";
-    case Key::F8: return "F8";
-    case Key::F9: return "F9";
-    case Key::F10: return "F10";
-    case Key::F11: return "F11";
-    case Key::F12: return "F12";
-    case Key::F13: return "F13";
-    case Key::F14: return "F14";
-    case Key::F15: return "F15";
-    case Key::F16: return "F16";
-    case Key::F17: return "F17";
-    case Key::F18: return "F18";
-    case Key::F19: return "F19";
-    case Key::F20: return "F20";
-    case Key::F21: return "F21";
-    case Key::F22: return "F22";
-    case Key::F23: return "F23";
-    case Key::F24: return "F24";
-    case Key::NumLock: return "Num Lock";
-    case Key::ScrollLock: return "Scroll Lock";
+// Names of keys as they should be displayed to the user
+struct KeyName { Key key; std::string_view name; };
+
+constexpr KeyName keyNames[] = {
+    { Key::Backspace, "Backspace" },
+    { Key::Tab, "Tab" },
+    { Key::Return, "Return" },
+    { Key::Escape, "Escape" },
+    { Key::Space, "Space" },
+    { Key::Apostrophe, "Apostrophe" },
+    { Key::Comma, "Comma" },
+    { Key::Dash, "Dash" },
+    { Key::Period, "Period" },
+    { Key::Slash, "Slash" },
+    { Key::Num0, "0" },
+    { Key::Num1, "1" },
+    { Key::Num2, "2" },
+    { Key::Num3, "3" },
+    { Key::Num4, "4" },
+    { Key::Num5, "5" },
+    { Key::Num6, "6" },
+    { Key::Num7, "7" },
+    { Key::Num8, "8" },
+    { Key::Num9, "9" },
+    { Key::Semicolon, "Semicolon" },
+    { Key::Equal, "Equal" },
+    { Key::A, "A" },
+    { Key::B, "B" },
+    { Key::C, "C" },
+    { Key::D, "D" },
+    { Key::E, "E" },
+    { Key::F, "F" },
+    { Key::G, "G" },
+    { Key::H, "H" },
+    { Key::I, "I" },
+    { Key::J, "J" },
+    { Key::K, "K" },
+    { Key::L, "L" },
+    { Key::M, "M" },
+    { Key::N, "N" },
+    { Key::O, "O" },
+    { Key::P, "P" },
+    { Key::Q, "Q" },
+    { Key::R, "R" },
+    { Key::S, "S" },
+    { Key::T, "T" },
+    { Key::U, "U" },
+    { Key::V, "V" },
+    { Key::W, "W" },
+    { Key::X, "X" },
+    { Key::Y, "Y" },
+    { Key::Z, "Z" },
+    { Key::LBracket, "Left Bracket" },
+    { Key::Backslash, "Backslash" },
+    { Key::RBracket, "Right Bracket" },
+    { Key::Backtick, "Backtick" },
+    { Key::Delete, "Delete" },
+    { Key::Clear, "Clear" },
+    { Key::LShift, "Left Shift" },
+    { Key::RShift, "Right Shift" },
+    { Key::LControl, "Left Control" },
+    { Key::RControl, "Right Control" },
+    { Key::LAlt, "Left Alt" },
+    { Key::RAlt, "Right Alt" },
+    { Key::Pause, "Pause" },
+    { Key::CapsLock, "Caps Lock" },
+    { Key::PageUp, "Page Up" },
+    { Key::PageDown, "Page Down" },
+    { Key::End, "End" },
+    { Key::Home, "Home" },
+    { Key::Left, "Left" },
+    { Key::Up, "Up" },
+    { Key::Right, "Right" },
+    { Key::Down, "Down" },
+    { Key::Select, "Select" },
+    { Key::PrintScreen, "Print Screen" },
+    { Key::Insert, "Insert" },
+    { Key::LMeta, "Left Meta" },
+    { Key::RMeta, "Right Meta" },
+    { Key::Menu, "Menu" },
+    { Key::Numpad0, "Numpad 0" },
+    { Key::Numpad1, "Numpad 1" },
+    { Key::Numpad2, "Numpad 2" },
+    { Key::Numpad3, "Numpad 3" },
+    { Key::Numpad4, "Numpad 4" },
+    { Key::Numpad5, "Numpad 5" },
+    { Key::Numpad6, "Numpad 6" },
+    { Key::Numpad7, "Numpad 7" },
+    { Key::Numpad8, "Numpad 8" },
+    { Key::Numpad9, "Numpad 9" },
+    { Key::Multiply, "Multiply" },
+    { Key::Add, "Add" },
+    { Key::Subtract, "Subtract" },
+    { Key::Decimal, "Decimal" },
+    { Key::Divide, "Divide" },
+    { Key::F1, "F1" },
+    { Key::F2, "F2" },
+    { Key::F3, "F3" },
+    { Key::F4, "F4" },
+    { Key::F5, "F5" },
+    { Key::F6, "F6" },
+    { Key::F7, "F7" },
+    { Key::F8, "F8" },
+    { Key::F9, "F9" },
+    { Key::F10, "F10" },
+    { Key::F11, "F11" },
+    { Key::F12, "F12" },
+    { Key::F13, "F13" },
+    { Key::F14, "F14" },
+    { Key::F15, "F15" },
+    { Key::F16, "F16" },
+    { Key::F17, "F17" },
+    { Key::F18, "F18" },
+    { Key::F19, "F19" },
+    { Key::F20, "F20" },
+    { Key::F21, "F21" },
+    { Key::F22, "F22" },
+    { Key::F23, "F23" },
+    { Key::F24, "F24" },
+    { Key::NumLock, "Num Lock" },
+    { Key::ScrollLock, "Scroll Lock" },
+};
+
+// Additional names accepted by parseKeyName(), on top of those in keyNames
+// Includes the enum identifiers and their aliases, e.g. "LCtrl" or "PgUp"
+constexpr KeyName keyNameAliases[] = {
+    { Key::Backspace, "Back" },
+    { Key::Return, "Enter" },
+    { Key::Escape, "Esc" },
+    { Key::Apostrophe, "Quote" },
+    { Key::Comma, "Less" },
+    { Key::Dash, "Minus" },
+    { Key::Dash, "Underscore" },
+    { Key::Period, "Greater" },
+    { Key::Slash, "QuestionMark" },
+    { Key::Num0, "Num0" },
+    { Key::Num0, "RParenthesis" },
+    { Key::Num0, "RParen" },
+    { Key::Num1, "Num1" },
+    { Key::Num1, "ExclamationMark" },
+    { Key::Num2, "Num2" },
+    { Key::Num2, "AtSign" },
+    { Key::Num3, "Num3" },
+    { Key::Num3, "Hash" },
+    { Key::Num4, "Num4" },
+    { Key::Num4, "Dollar" },
+    { Key::Num5, "Num5" },
+    { Key::Num5, "Percent" },
+    { Key::Num6, "Num6" },
+    { Key::Num6, "Caret" },
+    { Key::Num7, "Num7" },
+    { Key::Num7, "Ampersand" },
+    { Key::Num7, "Amp" },
+    { Key::Num8, "Num8" },
+    { Key::Num8, "Asterisk" },
+    { Key::Num9, "Num9" },
+    { Key::Num9, "LParenthesis" },
+    { Key::Num9, "LParen" },
+    { Key::Semicolon, "Colon" },
+    { Key::Equal, "Plus" },
+    { Key::LBracket, "LBracket" },
+    { Key::LBracket, "LBrace" },
+    { Key::Backslash, "Pipe" },
+    { Key::RBracket, "RBracket" },
+    { Key::RBracket, "RBrace" },
+    { Key::Backtick, "Grave" },
+    { Key::Backtick, "Tilde" },
+    { Key::Delete, "Del" },
+    { Key::LShift, "LShift" },
+    { Key::RShift, "RShift" },
+    { Key::LControl, "LControl" },
+    { Key::LControl, "LCtrl" },
+    { Key::RControl, "RControl" },
+    { Key::RControl, "RCtrl" },
+    { Key::LAlt, "LAlt" },
+    { Key::RAlt, "RAlt" },
+    { Key::CapsLock, "CapsLk" },
+    { Key::CapsLock, "Caps" },
+    { Key::PageUp, "PgUp" },
+    { Key::PageDown, "PgDn" },
+    { Key::PrintScreen, "PrtScr" },
+    { Key::Insert, "Ins" },
+    { Key::LMeta, "LMeta" },
+    { Key::RMeta, "RMeta" },
+    { Key::Menu, "Context" },
+    { Key::Multiply, "Mul" },
+    { Key::Subtract, "Sub" },
+    { Key::Decimal, "Dec" },
+    { Key::Divide, "Div" },
+    { Key::NumLock, "NumLk" },
+    { Key::ScrollLock, "ScrLk" },
+};
+
+namespace detail {
+
+// Key names are compared ignoring ASCII case and spaces, so "Page Up",
+// "PageUp" and "pageup" are all the same name
+constexpr bool isIgnoredNameChar(char c) { return c == ' '; }
+
+constexpr char foldNameChar(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+constexpr bool keyNamesEqual(std::string_view a, std::string_view b) {
+    std::size_t i = 0, j = 0;
+    while (true) {
+        while (i < a.size() && isIgnoredNameChar(a[i])) i++;
+        while (j < b.size() && isIgnoredNameChar(b[j])) j++;
+        if (i == a.size() || j == b.size()) return i == a.size() && j == b.size();
+        if (foldNameChar(a[i++]) != foldNameChar(b[j++])) return false;
+    }
+}
+
+// Seeded FNV-1a over the folded name, with a final avalanche so every seed
+// gives an independent looking hash
+constexpr std::uint32_t hashKeyName(std::string_view name, std::uint32_t seed) {
+    std::uint32_t hash = 2166136261u ^ (seed * 0x9E3779B9u);
+    for (char c : name) {
+        if (isIgnoredNameChar(c)) continue;
+        hash ^= static_cast<unsigned char>(foldNameChar(c));
+        hash *= 16777619u;
+    }
+    hash ^= hash >> 15;
+    hash *= 0x2C1B3C6Du;
+    hash ^= hash >> 12;
+    return hash;
+}
+
+// Table indexed by key code, giving the display name of each key
+class KeyNameTable {
+public:
+    constexpr KeyNameTable() {
+        for (auto& name : names) name = "Unknown Key";
+        for (const auto& it : keyNames) names[static_cast<std::size_t>(it.key)] = it.name;
+    }
+
+    constexpr std::string_view find(Key key) const {
+        auto index = static_cast<std::size_t>(key);
+        return index < size ? names[index] : names[0];
     }
 
-    return "Unknown Key";
+private:
+    static constexpr std::size_t size = static_cast<std::size_t>(Key::LastKey) + 1;
+    std::string_view names[size] = {};
+};
+
+// Compile-time perfect hash from key names and aliases to keys, using hash
+// and displace: each name is first hashed into a bucket, and each bucket gets
+// its own seed chosen so that all of its names land in unused slots
+// A lookup is two hashes of the name and one comparison
+class KeyParseTable {
+public:
+    static constexpr std::size_t nameCount 
+        = sizeof(keyNames) / sizeof(keyNames[0]) 
+        + sizeof(keyNameAliases) / sizeof(keyNameAliases[0]);
+    static constexpr std::size_t slotCount = 512;
+    static constexpr std::size_t bucketCount = 64;
+    static constexpr std::uint8_t emptySlot = 0xFF;
+
+    static_assert(nameCount < emptySlot, "Too many key names for 8-bit slots");
+
+    constexpr KeyParseTable() {
+        std::size_t entryBuckets[nameCount] = {};
+        std::size_t bucketSizes[bucketCount] = {};
+
+        for (std::size_t i = 0; i < nameCount; i++) {
+            entries[i] = i < std::size(keyNames) 
+                ? keyNames[i] 
+                : keyNameAliases[i - std::size(keyNames)];
+            entryBuckets[i] = bucketOf(entries[i].name);
+            bucketSizes[entryBuckets[i]]++;
+        }
+        for (auto& slot : slots) slot = emptySlot;
+
+        // Equal names always share a bucket, and would never find free slots
+        for (std::size_t i = 0; i < nameCount; i++) {
+            for (std::size_t j = i + 1; j < nameCount; j++) {
+                if (entryBuckets[i] == entryBuckets[j] && keyNamesEqual(entries[i].name, entries[j].name))
+                    throw "Key names and aliases must be unique"; // Fails to compile
+            }
+        }
+
+        // Place the largest buckets first, while there is the most room
+        bool placed[bucketCount] = {};
+        for (std::size_t n = 0; n < bucketCount; n++) {
+            std::size_t bucket = bucketCount;
+            for (std::size_t b = 0; b < bucketCount; b++) {
+                if (!placed[b] && (bucket == bucketCount || bucketSizes[b] > bucketSizes[bucket]))
+                    bucket = b;
+            }
+            placed[bucket] = true;
+
+            for (std::uint32_t seed = 1; ; seed++) {
+                if (tryPlaceBucket(entryBuckets, bucket, seed)) {
+                    seeds[bucket] = seed;
+                    break;
+                }
+            }
+        }
+    }
+
+    constexpr Key find(std::string_view name) const {
+        std::uint32_t seed = seeds[bucketOf(name)];
+        std::uint8_t index = slots[slotOf(name, seed)];
+        if (index == emptySlot || !keyNamesEqual(entries[index].name, name)) return Key::Unknown;
+        return entries[index].key;
+    }
+
+private:
+    KeyName entries[nameCount] = {};
+    std::uint8_t slots[slotCount] = {};
+    std::uint32_t seeds[bucketCount] = {};
+
+    static constexpr std::size_t bucketOf(std::string_view name) {
+        return hashKeyName(name, 0) % bucketCount;
+    }
+
+    static constexpr std::size_t slotOf(std::string_view name, std::uint32_t seed) {
+        return hashKeyName(name, seed) % slotCount;
+    }
+
+    constexpr bool tryPlaceBucket(const std::size_t* entryBuckets, std::size_t bucket, std::uint32_t seed) {
+        for (std::size_t i = 0; i < nameCount; i++) {
+            if (entryBuckets[i] != bucket) continue;
+            
+            std::size_t slot = slotOf(entries[i].name, seed);
+            if (slots[slot] != emptySlot) {
+                // Undo the names of this bucket placed so far
+                for (std::size_t j = 0; j < i; j++) {
+                    if (entryBuckets[j] == bucket) slots[slotOf(entries[j].name, seed)] = emptySlot;
+                }
+                return false;
+            }
+            slots[slot] = static_cast<std::uint8_t>(i);
+        }
+
+        return true;
+    }
+};
+
+inline constexpr KeyNameTable keyNameTable;
+inline constexpr KeyParseTable keyParseTable;
+
+}
+
+// Get the display name of a key, e.g. "Left Shift"
+// The returned view refers to static storage and never allocates
+constexpr std::string_view getKeyName(Key key) {
+    return detail::keyNameTable.find(key);
+}
+
+// Get the key with the given name or alias, ignoring case and spaces, e.g.
+// "Left Shift", "LShift" and "lshift" all give Key::LShift
+// Returns Key::Unknown if the name is not recognized
+constexpr Key parseKeyName(std::string_view name) {
+    return detail::keyParseTable.find(name);
 }
 
 }
\ No newline at end of file
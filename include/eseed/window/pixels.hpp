@@ -0,0 +1,112 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+
+namespace esd::wnd {
+
+// Formats with 8 bits per channel are named by their byte order in memory,
+// packed formats by their fields from the most significant bit of a native
+// endian value
+// Rgba8888, Bgra8888 and Rgba16f (native endian half floats, linear) are only
+// used as sources for conversion, windows never present them directly
+enum struct PixelFormat {
+    Unknown,
+    Bgrx8888,
+    Rgbx8888,
+    Xrgb8888,
+    Xbgr8888,
+    Rgb565,
+    Xrgb2101010,
+    Rgba8888,
+    Bgra8888,
+    Rgba16f
+};
+
+struct Rect { int x, y, w, h; };
+
+// CPU-writable image, with rows stride bytes apart
+struct PixelBuffer {
+    void* data;
+    std::size_t stride;
+    int width, height;
+    PixelFormat format;
+};
+
+std::size_t getBytesPerPixel(PixelFormat format);
+
+// Planar video frame with chroma subsampled by 2 in both directions
+// I420 has separate U and V planes, NV12 one plane of interleaved U and V
+enum struct YuvFormat { I420, Nv12 };
+enum struct YuvMatrix { Bt601, Bt709 };
+enum struct YuvRange {
+    Limited, // Y from 16 to 235 and chroma from 16 to 240, as in most video
+    Full
+};
+
+struct YuvFrame {
+    YuvFormat format;
+    YuvMatrix matrix;
+    YuvRange range;
+    int width, height;
+
+    // Y, U and V planes for I420, Y and UV for NV12
+    const void* planes[3];
+    std::size_t strides[3];
+};
+
+// Whether convertPixels() can convert between two formats
+// Any format converts to itself, and Rgba8888, Bgra8888 and Rgba16f convert to
+// every format a window can present
+// With encodeSrgb, formats converting to themselves need 8 bits per channel
+bool isConversionSupported(PixelFormat from, PixelFormat to, bool encodeSrgb = false);
+
+// Convert the overlapping area of two buffers, starting from the top left
+// Uses SSE2, AVX2 or NEON kernels, picked based on the CPU when first used
+// Conversions go through 8 bits per channel, alpha is dropped and encodeSrgb
+// applies the sRGB transfer function to the color channels of linear sources
+// Throws if the conversion isn't supported
+void convertPixels(const PixelBuffer& from, const PixelBuffer& to, bool encodeSrgb = false);
+
+// Convert the overlapping area of a video frame into a buffer in any format a
+// window can present, writing every pixel once
+// Throws if the buffer's format is unsupported
+void convertYuv(const YuvFrame& from, const PixelBuffer& to);
+
+// How a small image is scaled up to a larger target, keeping its aspect ratio
+// and centering it with black bars
+// Integer scales by the largest whole factor that fits, so every pixel becomes
+// an equally sized block, falling back to Fit if the target is smaller than
+// the image
+// Fit scales by the largest factor that fits
+enum struct ScaleMode { Integer, Fit };
+
+// Area of the target an image is scaled to, e.g. to map pointer positions
+// back to image coordinates
+Rect getScaledRect(int width, int height, int targetWidth, int targetHeight, ScaleMode mode);
+
+// Scale with nearest neighbour sampling and convert in one pass, filling the
+// rest of the target with black
+// Throws if the conversion isn't supported
+void scalePixels(const PixelBuffer& from, const PixelBuffer& to, ScaleMode mode);
+
+}
@@ -34,7 +34,12 @@ namespace esd::wnd {
 
 class VulkanWindow : public Window {
 public:
-    VulkanWindow(std::string title, WindowSize size) : Window(title, size) {}
+    VulkanWindow(
+        std::string title, 
+        WindowSize size, 
+        std::optional<WindowPos> pos = std::nullopt, 
+        FullscreenMode fullscreenMode = FullscreenMode::Windowed
+    ) : Window(title, size, pos, fullscreenMode) {}
 
     // Get instance extensions required to create a Vulkan surface on the
     // current platform    
@@ -21,40 +21,176 @@
 #pragma once
 
 #include <eseed/window/input.hpp>
+#include <eseed/window/pixels.hpp>
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <functional>
 #include <optional>
 
 namespace esd::wnd {
 
+class Gamepads;
+class FramePacer;
+
 struct WindowSize { int w, h; };
 struct WindowPos { int x, y; };
 struct CursorPos { double x, y; };
 
 struct KeyEvent { Key key; bool down; };
 struct KeyCharEvent { char32_t codePoint; };
+// View of the text committed since the last poll, only valid during the handler
+struct TextInputEvent { std::string_view text; };
+// Incremental change to the input method's pre-edit (composition) text
+// Positions are in code points: changeLength code points from changeStart are
+// replaced with text, which is only valid during the handler
+// When done is set the composition has ended and the pre-edit text is empty
+struct PreeditEvent { 
+    std::size_t changeStart; 
+    std::size_t changeLength; 
+    std::string_view text; 
+    std::size_t caret;
+    bool done;
+};
 struct CursorMoveEvent { CursorPos pos; CursorPos screenPos; bool entered; };
 struct CursorExitEvent {};
 struct MouseButtonEvent { MouseButton button; bool down; };
+// Unaccelerated relative mouse motion, time is in platform milliseconds
+struct RawMotionSample { double dx, dy; std::uint32_t time; };
+// All raw motion samples received since the last poll, only valid during the
+// handler
+struct RawMotionEvent { const RawMotionSample* samples; std::size_t sampleCount; };
 struct ScrollEvent { double vScroll, hScroll; };
+// Pressure is from 0 to 1, and tilt from -1 to 1 across the pen's range on
+// each axis (0 if the pen doesn't report it)
+struct PenSample { double x, y, pressure, tiltX, tiltY; std::uint32_t time; };
+// Every pen sample since the last poll in order, only valid during the handler
+struct PenEvent { const PenSample* samples; std::size_t sampleCount; };
+enum struct TouchPhase : std::uint8_t { Began, Moved, Ended };
+// Touch points that changed since the last poll, as parallel arrays of count
+// elements, only valid during the handler
+// Movement of a touch is coalesced to its latest position, but a touch that
+// began and ended within one poll appears twice
+// Positions are in window coordinates, and pressure is from 0 to 1 (1 if the
+// device doesn't report it)
+struct TouchFrameEvent {
+    std::size_t count;
+    const std::uint32_t* ids;
+    const TouchPhase* phases;
+    const double* x;
+    const double* y;
+    const double* pressure;
+};
+// Areas of the window that need to be redrawn since the last poll, e.g. after
+// being uncovered, only valid during the handler
+// Rectangles covered by others are dropped, and bounds contains all of them
+struct DamageEvent { const Rect* rects; std::size_t rectCount; Rect bounds; };
 struct ResizeEvent { WindowSize size; };
 struct MoveEvent { WindowPos pos; };
 
+// How much of the window can be seen
+// Compositing window managers draw windows offscreen, so under them windows
+// are never reported as obscured, only as minimized
+enum struct Visibility {
+    Visible,
+    PartiallyObscured,
+    FullyObscured,
+    Minimized // Or otherwise not mapped
+};
+
+struct VisibilityEvent { Visibility visibility; };
+
+enum struct FullscreenMode {
+    Windowed,
+    Fullscreen,
+    // Fullscreen, also asking the compositor to stop compositing the window
+    // (_NET_WM_BYPASS_COMPOSITOR on X11), which saves a frame of latency
+    LowLatency
+};
+
+// What came of a fullscreen request, which the window manager may ignore
+struct FullscreenStatus {
+    bool fullscreen; // The window manager put the window in fullscreen state
+    bool composited; // A compositing manager is running
+    bool flipped; // The last frame presented with frame timing was flipped to the screen, so wasn't composited
+};
+
+// How a frame presented with frame timing reached the screen
+enum struct PresentMode : std::uint8_t {
+    Copy,
+    Flip, // Scanned out directly, without a copy
+    Skip, // Replaced by a newer frame before being shown
+    SuboptimalCopy
+};
+
+// A frame presented with frame timing reached the screen
+// Frames are numbered from 1 in the order they are presented, the same as
+// getPresentFrameNumber(), and only this window's own frames are reported,
+// not ones other clients present to it, e.g. through Vulkan; ust is when it
+// was shown in microseconds on the server's monotonic clock (CLOCK_MONOTONIC
+// on Linux) and msc is the vblank counter of the monitor it was shown on
+struct PresentCompleteEvent {
+    std::uint32_t frame;
+    std::uint64_t ust;
+    std::uint64_t msc;
+    PresentMode mode;
+};
+
+// Statistics of asynchronous presenting, latencies are in seconds from
+// submitting a frame to it being put in the window
+struct PresentStats {
+    std::uint64_t submitted;
+    std::uint64_t presented;
+    std::uint64_t replaced; // Replaced by a newer frame before being presented
+    double lastLatency;
+    double averageLatency;
+    double maxLatency;
+};
+
+// File formats window capture writes
+enum struct CaptureFormat {
+    Y4m, // YUV 4:2:0, BT.601 limited range
+    Raw // Bgrx8888 frames back to back, without a header
+};
+
+struct CaptureStats {
+    std::uint64_t frames; // Written to the file, including repeated ones
+    std::uint64_t unchanged; // Repeated because the window hadn't changed
+    std::uint64_t dropped; // Repeated because the writer fell behind
+    std::uint64_t bytesWritten;
+};
+
 class Window {
 public:
-    Window(std::string title, WindowSize size, std::optional<WindowPos> pos = std::nullopt);
+    // Windows created fullscreen cover the monitor at pos when they are first
+    // mapped, so the window manager doesn't need to resize them
+    Window(
+        std::string title, 
+        WindowSize size, 
+        std::optional<WindowPos> pos = std::nullopt, 
+        FullscreenMode fullscreenMode = FullscreenMode::Windowed
+    );
     Window(const Window&) = delete;
     ~Window();
 
     void setKeyHandler(std::function<void(KeyEvent)> handler) { keyHandler = handler; }
     void setKeyCharHandler(std::function<void(KeyCharEvent)> handler) { keyCharHandler = handler; }
+    void setTextInputHandler(std::function<void(TextInputEvent)> handler) { textInputHandler = handler; }
+    void setPreeditHandler(std::function<void(PreeditEvent)> handler) { preeditHandler = handler; }
     void setCursorMoveHandler(std::function<void(CursorMoveEvent)> handler) { cursorMoveHandler = handler; }
     void setCursorExitHandler(std::function<void(CursorExitEvent)> handler) { cursorExitHandler = handler; }
     void setMouseButtonHandler(std::function<void(MouseButtonEvent)> handler) { mouseButtonHandler = handler; }
+    void setRawMotionHandler(std::function<void(RawMotionEvent)> handler) { rawMotionHandler = handler; }
     void setScrollHandler(std::function<void(ScrollEvent)> handler) { scrollHandler = handler; }
+    void setPenHandler(std::function<void(PenEvent)> handler) { penHandler = handler; }
+    void setTouchFrameHandler(std::function<void(TouchFrameEvent)> handler) { touchFrameHandler = handler; }
+    void setDamageHandler(std::function<void(DamageEvent)> handler) { damageHandler = handler; }
+    void setPresentCompleteHandler(std::function<void(PresentCompleteEvent)> handler) { presentCompleteHandler = handler; }
     void setResizeHandler(std::function<void(ResizeEvent)> handler) { resizeHandler = handler; }
     void setMoveHandler(std::function<void(MoveEvent)> handler) { moveHandler = handler; }
+    void setVisibilityHandler(std::function<void(VisibilityEvent)> handler) { visibilityHandler = handler; }
 
     // Close the window and release all resources
     // The window cannot be used again after this call
@@ -75,12 +211,32 @@ public:
     WindowPos getPos();
     void setPos(WindowPos pos);
 
+    // Refresh rate of the monitor the window is on, in Hz, 0 if unknown
+    // Queries the system, so it isn't meant to be called every frame
+    double getRefreshRate();
+
     bool isCloseRequested();
     void setCloseRequested(bool closeRequested);
 
+    // Visibility as of the last poll, without asking the system
+    // Windows that can't be seen at all (fully obscured or minimized) don't
+    // need to be rendered
+    Visibility getVisibility();
+    bool isVisible();
+
     bool isFullscreen();
     void setFullscreen(bool fullscreen);
 
+    // setFullscreen() switches between Windowed and Fullscreen
+    FullscreenMode getFullscreenMode();
+    void setFullscreenMode(FullscreenMode mode);
+
+    // The window manager applies fullscreen requests asynchronously, so this
+    // reflects them after a later poll
+    // Whether the compositor is bypassed is only known from frames presented
+    // with frame timing, or when no compositor runs
+    FullscreenStatus getFullscreenStatus();
+
     bool isKeyDown(Key key);
 
     // Get toggle state of applicable keys like caps lock or num lock
@@ -95,20 +251,136 @@ public:
 
     bool isMouseButtonDown(MouseButton button);
 
+    // Raw motion delivers unaccelerated, sub-pixel mouse deltas while the
+    // window has focus, batched into one event per poll
+    // Not all systems support it (X11 requires XInput 2)
+    bool isRawMotionSupported();
+    bool isRawMotionEnabled();
+    void setRawMotionEnabled(bool enabled);
+
+    // Lock the cursor to the window and hide it, e.g. for first person
+    // cameras
+    // While locked, movement is only delivered as relative motion through the
+    // raw motion handler, and cursor move events are not sent
+    bool isCursorLocked();
+    void setCursorLocked(bool locked);
+
+    // Software rendering: draw into the pixel buffer, then present it to show
+    // it in the window
+    // The buffer has the window's size and native pixel format, and is
+    // reallocated when the size changes, so it must be fetched again for
+    // every frame
+    // On X11 it is in shared memory when the server supports it, so
+    // presenting doesn't copy the pixels over the connection
+    PixelBuffer getPixelBuffer();
+    void presentPixelBuffer();
+
+    // Present only the given areas of the pixel buffer, e.g. the rectangles of
+    // a damage event or the parts of the frame that changed
+    void presentPixelBuffer(const Rect* rects, std::size_t rectCount);
+
+    // Convert pixels in any supported format into the pixel buffer and present
+    // them, see convertPixels()
+    void presentPixels(const PixelBuffer& pixels, bool encodeSrgb = false);
+
+    // Scale pixels up to the window size, see scalePixels(), and present them
+    // The scale follows the window size on every present
+    void presentPixelsScaled(const PixelBuffer& pixels, ScaleMode mode = ScaleMode::Integer);
+
+    // Convert a video frame into the pixel buffer and present it, see
+    // convertYuv()
+    void presentYuv(const YuvFrame& frame);
+
+    // Window capture: record the window's contents to a video file with a
+    // fixed frame rate, one frame for every call to captureFrame
+    // Frames are grabbed into a few reused buffers, in shared memory if
+    // possible, and written by a background thread
+    // If the window hasn't changed since the last frame, or the writer is
+    // behind, the previous frame is written again so timing is kept
+    // The size is fixed when capture starts, frames of other sizes are
+    // cropped or padded with black
+    // Unsupported on Win32, throws if capture can't start
+    void startCapture(const std::string& path, CaptureFormat format, double frameRate = 60);
+    void captureFrame();
+
+    // Write all captured frames and close the file, rethrowing any error
+    // from writing
+    void stopCapture();
+    CaptureStats getCaptureStats();
+
+    // Frame timing: present the pixel buffer through the X Present extension,
+    // reporting when every frame reached the screen through the present
+    // complete handler
+    // Frames are copied into a few window-sized pixmaps, each reused once the
+    // server reports it idle, and are always presented whole
+    // Unsupported on Win32 and on servers without the extension, in which
+    // case enabling it does nothing
+    bool isPresentTimingSupported();
+    bool isPresentTimingEnabled();
+    void setPresentTimingEnabled(bool enabled);
+
+    // Number of the last frame presented with frame timing, 0 before the
+    // first
+    std::uint32_t getPresentFrameNumber();
+
+    // Asynchronous software rendering: frames are drawn on any thread, and
+    // a present thread owned by the window converts them to the window's
+    // format and puts them in the window
+    // There are three frames, one being drawn, one waiting and one being
+    // presented, so acquiring never blocks; submitting a frame while another
+    // is still waiting replaces it, and only the newest is presented
+    void startAsyncPresent(PixelFormat format);
+    void stopAsyncPresent();
+
+    // Get the frame to draw, in the format given when starting, reallocated
+    // if its size changes
+    // Frames don't need to match the window size, they are presented from the
+    // top left and clipped
+    PixelBuffer acquireFrame(int width, int height);
+
+    // Hand the acquired frame over to the present thread
+    // Rethrows errors from the present thread, after which it has stopped
+    void submitFrame();
+    PresentStats getPresentStats();
+
+    // Poll the gamepads along with this window's events, and have
+    // waitEvents() also wake up for their input
+    // The gamepads must outlive the window, or be detached with nullptr first
+    void setGamepads(Gamepads* gamepads);
+
 protected:
+    friend class FramePacer;
+
     // Should be defined in the platform-specific source file with data members
     // and additional functions
     class Impl;
     std::unique_ptr<Impl> impl;
 
+    // Select completions of every present to the window while a vblank
+    // handler is set, without changing how the pixel buffer is presented
+    void setPresentVblankHandler(std::function<void(std::uint64_t)> handler);
+
     std::function<void(KeyEvent)> keyHandler;
     std::function<void(KeyCharEvent)> keyCharHandler;
+    std::function<void(TextInputEvent)> textInputHandler;
+    std::function<void(PreeditEvent)> preeditHandler;
     std::function<void(CursorMoveEvent)> cursorMoveHandler;
     std::function<void(CursorExitEvent)> cursorExitHandler;
     std::function<void(MouseButtonEvent)> mouseButtonHandler;
+    std::function<void(RawMotionEvent)> rawMotionHandler;
     std::function<void(ScrollEvent)> scrollHandler;
+    std::function<void(PenEvent)> penHandler;
+    std::function<void(TouchFrameEvent)> touchFrameHandler;
+    std::function<void(DamageEvent)> damageHandler;
+    std::function<void(PresentCompleteEvent)> presentCompleteHandler;
+
+    // Called on polls with the ust the latest frame was shown at, including
+    // frames of other clients, so the frame pacer can follow the vblanks of
+    // apps presenting through e.g. Vulkan
+    std::function<void(std::uint64_t)> presentVblankHandler;
     std::function<void(ResizeEvent)> resizeHandler;
     std::function<void(MoveEvent)> moveHandler;
+    std::function<void(VisibilityEvent)> visibilityHandler;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,69 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#include <eseed/window/gamepad.hpp>
+#include <stdexcept>
+#include <vector>
+
+using namespace esd::wnd;
+
+// Gamepads aren't implemented on Win32 yet, so no pads are ever connected
+class Gamepads::Impl {
+public:
+    std::vector<GamepadState> states;
+};
+
+Gamepads::Gamepads() {
+    impl = std::make_unique<Impl>();
+}
+
+Gamepads::~Gamepads() {}
+
+void Gamepads::poll() {}
+
+int Gamepads::open(const std::string& path) {
+    throw std::runtime_error("Opening gamepads by path is unsupported on Win32");
+}
+
+std::size_t Gamepads::getCount() {
+    return impl->states.size();
+}
+
+bool Gamepads::isConnected(int id) {
+    return false;
+}
+
+std::string Gamepads::getName(int id) {
+    return std::string();
+}
+
+std::string Gamepads::getGuid(int id) {
+    return std::string();
+}
+
+void Gamepads::loadMappings(const std::string& path) {}
+
+const GamepadState& Gamepads::getState(int id) {
+    return impl->states.at(id);
+}
+
+const GamepadState* Gamepads::getStates() {
+    return impl->states.data();
+}
@@ -20,18 +20,64 @@
 
 #pragma once
 
+#include "framemailbox.hpp"
 #include <eseed/window/window.hpp>
 #include <windows.h>
 #include <winuser.h>
+#include <memory>
+#include <thread>
+#include <vector>
 
 class esd::wnd::Window::Impl {
 public:
     HINSTANCE hInstance;
     HWND hWnd;
     WINDOWPLACEMENT windowedPlacement; // For caching non-fullscreen dimensions
+    FullscreenMode fullscreenMode;
     bool closeRequested;
     bool cursorInWindow;
+    std::string pendingText; // Text committed during the current poll
+    wchar_t highSurrogate = 0; // First half of a character split over two WM_CHARs
+    double pendingVScroll; // Scrolling accumulated during the current poll
+    double pendingHScroll;
+    bool rawMotionEnabled;
+    bool cursorLocked;
+    std::vector<RawMotionSample> rawMotionSamples; // Reused between polls
+    Gamepads* gamepads; // Polled along with the window, if attached
+    Visibility visibility = Visibility::Minimized; // Last delivered
+
+    // Software present target, a top-down 32 bit DIB section selected into a
+    // memory DC, reallocated when the client size changes
+    HDC bitmapDc;
+    HBITMAP bitmap;
+    void* bitmapBits;
+    int bitmapWidth, bitmapHeight;
+
+    void destroyBitmap();
+
+    // Create a top-down 32 bit DIB section, throwing if it fails
+    static HBITMAP createBitmap(int width, int height, void*& bits);
+
+    // Asynchronous presenting, blitting from a DIB section owned by the
+    // present thread
+    std::unique_ptr<FrameMailbox> asyncFrames;
+    std::thread asyncThread;
+    void runAsyncPresent();
+
+    // Areas invalidated during the current poll
+    std::vector<Rect> damageRects;
+
+    // Add to the damage of the current poll, skipping rectangles that are
+    // already covered and dropping ones the new rectangle covers
+    void addDamage(const Rect& rect);
     
+    // Register for raw mouse input only while raw motion or cursor lock need
+    // it
+    void updateRawMouseRegistration();
+
+    // Confine the cursor to the client area while locked
+    void clipLockedCursor();
+
     // Convert window client dimensions to Win32 window RECT
     RECT createWindowRect(WindowSize size, WindowPos pos = {});
 
@@ -52,6 +98,9 @@ public:
     // Win32 HOOKPROC
     static LRESULT CALLBACK lowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam);
 
+    // Append a code point to a UTF-8 string
+    static void appendUtf8(std::string& string, char32_t codePoint);
+
     static std::string wideStringToString(const std::wstring& wstring);
     static std::wstring stringToWideString(const std::string& string);
 };
\ No newline at end of file
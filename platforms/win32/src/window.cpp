@@ -19,21 +19,25 @@
 // SOFTWARE.
 
 #include <eseed/window/window.hpp>
+#include <eseed/window/gamepad.hpp>
 
 #include "inputmappings.hpp"
 #include "impl.hpp"
 #include <windows.h>
 #include <winuser.h>
 #include <windowsx.h>
+#include <algorithm>
 #include <iostream>
 #include <set>
+#include <stdexcept>
 
 using namespace esd::wnd;
 
 Window::Window(
     std::string title, 
     WindowSize size, 
-    std::optional<WindowPos> pos
+    std::optional<WindowPos> pos, 
+    FullscreenMode fullscreenMode
 ) {
 
     impl = std::make_unique<Impl>();
@@ -76,6 +80,10 @@ Window::Window(
     // Set "this" pointer in window user data for use in WNDPROC
     SetWindowLongPtrW(impl->hWnd, GWLP_USERDATA, (LONG_PTR)this);
 
+    // Made fullscreen while still hidden, so it is shown covering the monitor
+    impl->fullscreenMode = FullscreenMode::Windowed;
+    if (fullscreenMode != FullscreenMode::Windowed) setFullscreenMode(fullscreenMode);
+
     ShowWindow(impl->hWnd, SW_SHOW);
 
     // Register raw input devices
@@ -96,6 +104,8 @@ Window::~Window() {
 }
 
 void Window::close() {
+    stopAsyncPresent();
+    impl->destroyBitmap();
     DestroyWindow(impl->hWnd);
     impl->hWnd = nullptr;
 }
@@ -106,6 +116,77 @@ void Window::poll() {
         TranslateMessage(&msg);
         DispatchMessageW(&msg);
     }
+
+    // Scrolling is accumulated into one event per poll
+    if (impl->pendingVScroll != 0.0 || impl->pendingHScroll != 0.0) {
+        if (scrollHandler) {
+            ScrollEvent event;
+            event.vScroll = impl->pendingVScroll;
+            event.hScroll = impl->pendingHScroll;
+            scrollHandler(event);
+        }
+        impl->pendingVScroll = 0.0;
+        impl->pendingHScroll = 0.0;
+    }
+
+    if (!impl->rawMotionSamples.empty()) {
+        if (rawMotionHandler) {
+            RawMotionEvent event;
+            event.samples = impl->rawMotionSamples.data();
+            event.sampleCount = impl->rawMotionSamples.size();
+            rawMotionHandler(event);
+        }
+        impl->rawMotionSamples.clear();
+    }
+
+    // Invalidated areas are accumulated into one damage event per poll
+    if (!impl->damageRects.empty()) {
+        if (damageHandler) {
+            int x1 = impl->damageRects[0].x;
+            int y1 = impl->damageRects[0].y;
+            int x2 = x1 + impl->damageRects[0].w;
+            int y2 = y1 + impl->damageRects[0].h;
+            for (const auto& rect : impl->damageRects) {
+                x1 = std::min(x1, rect.x);
+                y1 = std::min(y1, rect.y);
+                x2 = std::max(x2, rect.x + rect.w);
+                y2 = std::max(y2, rect.y + rect.h);
+            }
+
+            DamageEvent event;
+            event.rects = impl->damageRects.data();
+            event.rectCount = impl->damageRects.size();
+            event.bounds = { x1, y1, x2 - x1, y2 - y1 };
+            damageHandler(event);
+        }
+        impl->damageRects.clear();
+    }
+
+    // All text committed during this poll is delivered as one event
+    if (!impl->pendingText.empty()) {
+        if (textInputHandler) {
+            TextInputEvent event;
+            event.text = impl->pendingText;
+            textInputHandler(event);
+        }
+        impl->pendingText.clear();
+    }
+
+    // Win32 doesn't tell windows when others cover them, so only minimizing
+    // and hiding are reported
+    Visibility visibility = IsIconic(impl->hWnd) || !IsWindowVisible(impl->hWnd)
+        ? Visibility::Minimized
+        : Visibility::Visible;
+    if (visibility != impl->visibility) {
+        impl->visibility = visibility;
+        if (visibilityHandler) {
+            VisibilityEvent event;
+            event.visibility = visibility;
+            visibilityHandler(event);
+        }
+    }
+
+    if (impl->gamepads) impl->gamepads->poll();
 }
 
 void Window::waitEvents() {
@@ -189,6 +270,20 @@ void Window::setPos(WindowPos pos) {
     );
 }
 
+double Window::getRefreshRate() {
+    MONITORINFOEXW monitorInfo = {};
+    monitorInfo.cbSize = sizeof(monitorInfo);
+    HMONITOR monitor = MonitorFromWindow(impl->hWnd, MONITOR_DEFAULTTONEAREST);
+    if (!GetMonitorInfoW(monitor, &monitorInfo)) return 0;
+
+    DEVMODEW mode = {};
+    mode.dmSize = sizeof(mode);
+    if (!EnumDisplaySettingsW(monitorInfo.szDevice, ENUM_CURRENT_SETTINGS, &mode)) return 0;
+
+    // 0 and 1 stand for the hardware's default rate
+    return mode.dmDisplayFrequency > 1 ? mode.dmDisplayFrequency : 0;
+}
+
 bool Window::isCloseRequested() {
     return impl->closeRequested;
 }
@@ -197,12 +292,21 @@ void Window::setCloseRequested(bool closeRequested) {
     impl->closeRequested = closeRequested;
 }
 
+Visibility Window::getVisibility() {
+    return impl->visibility;
+}
+
+bool Window::isVisible() {
+    return impl->visibility == Visibility::Visible;
+}
+
 bool Window::isFullscreen() {
     // Fullscreen won't have overlapped window style
     return !(GetWindowLong(impl->hWnd, GWL_STYLE) & WS_OVERLAPPEDWINDOW);
 }
 
 void Window::setFullscreen(bool fullscreen) {
+    impl->fullscreenMode = fullscreen ? FullscreenMode::Fullscreen : FullscreenMode::Windowed;
 
     if (fullscreen) {
         MONITORINFO mi = { sizeof(mi) };
@@ -250,6 +354,26 @@ void Window::setFullscreen(bool fullscreen) {
     InvalidateRect(impl->hWnd, nullptr, TRUE);
 }
 
+FullscreenMode Window::getFullscreenMode() {
+    return impl->fullscreenMode;
+}
+
+void Window::setFullscreenMode(FullscreenMode mode) {
+    // DWM stops composing windows that cover the monitor on its own, so low
+    // latency needs nothing more than fullscreen
+    bool fullscreen = mode != FullscreenMode::Windowed;
+    if (fullscreen != isFullscreen()) setFullscreen(fullscreen);
+    impl->fullscreenMode = mode;
+}
+
+FullscreenStatus Window::getFullscreenStatus() {
+    FullscreenStatus status;
+    status.fullscreen = isFullscreen();
+    status.composited = true; // DWM can't be turned off since Windows 8
+    status.flipped = false; // No frame timing
+    return status;
+}
+
 bool Window::isKeyDown(Key keyCode) {
     for (auto it : keyMappings) {
         if (it.second == keyCode) return GetKeyState(it.first) & 0x8000;
@@ -297,6 +421,261 @@ bool Window::isMouseButtonDown(MouseButton button) {
     throw std::runtime_error("Unknown mouse button");
 }
 
+bool Window::isRawMotionSupported() {
+    return true;
+}
+
+bool Window::isRawMotionEnabled() {
+    return impl->rawMotionEnabled;
+}
+
+void Window::setRawMotionEnabled(bool enabled) {
+    if (impl->rawMotionEnabled == enabled) return;
+    impl->rawMotionEnabled = enabled;
+    impl->rawMotionSamples.clear();
+    impl->updateRawMouseRegistration();
+}
+
+void Window::setGamepads(Gamepads* gamepads) {
+    impl->gamepads = gamepads;
+}
+
+PixelBuffer Window::getPixelBuffer() {
+    RECT rect;
+    GetClientRect(impl->hWnd, &rect);
+    int width = std::max<int>(rect.right - rect.left, 1);
+    int height = std::max<int>(rect.bottom - rect.top, 1);
+
+    if (!impl->bitmap || impl->bitmapWidth != width || impl->bitmapHeight != height) {
+        impl->destroyBitmap();
+        impl->bitmap = Impl::createBitmap(width, height, impl->bitmapBits);
+        impl->bitmapDc = CreateCompatibleDC(nullptr);
+        SelectObject(impl->bitmapDc, impl->bitmap);
+        impl->bitmapWidth = width;
+        impl->bitmapHeight = height;
+    } else {
+        // GDI may still be reading the bitmap for a batched blit
+        GdiFlush();
+    }
+
+    PixelBuffer buffer;
+    buffer.data = impl->bitmapBits;
+    buffer.stride = static_cast<std::size_t>(width) * 4;
+    buffer.width = width;
+    buffer.height = height;
+    buffer.format = PixelFormat::Bgrx8888;
+    return buffer;
+}
+
+void Window::presentPixelBuffer() {
+    if (!impl->bitmap) return;
+
+    HDC dc = GetDC(impl->hWnd);
+    BitBlt(dc, 0, 0, impl->bitmapWidth, impl->bitmapHeight, impl->bitmapDc, 0, 0, SRCCOPY);
+    ReleaseDC(impl->hWnd, dc);
+}
+
+void Window::presentPixelBuffer(const Rect* rects, std::size_t rectCount) {
+    if (!impl->bitmap) return;
+
+    HDC dc = GetDC(impl->hWnd);
+    for (std::size_t i = 0; i < rectCount; i++) {
+        const Rect& rect = rects[i];
+        BitBlt(dc, rect.x, rect.y, rect.w, rect.h, impl->bitmapDc, rect.x, rect.y, SRCCOPY);
+    }
+    ReleaseDC(impl->hWnd, dc);
+}
+
+void Window::Impl::addDamage(const Rect& rect) {
+    if (rect.w <= 0 || rect.h <= 0) return;
+
+    auto contains = [](const Rect& outer, const Rect& inner) {
+        return inner.x >= outer.x && inner.y >= outer.y
+            && inner.x + inner.w <= outer.x + outer.w 
+            && inner.y + inner.h <= outer.y + outer.h;
+    };
+
+    for (const auto& damageRect : damageRects) {
+        if (contains(damageRect, rect)) return;
+    }
+    damageRects.erase(
+        std::remove_if(damageRects.begin(), damageRects.end(), 
+            [&](const Rect& damageRect) { return contains(rect, damageRect); }),
+        damageRects.end()
+    );
+    damageRects.push_back(rect);
+}
+
+void Window::Impl::destroyBitmap() {
+    if (!bitmap) return;
+    DeleteDC(bitmapDc);
+    DeleteObject(bitmap);
+    bitmap = nullptr;
+}
+
+HBITMAP Window::Impl::createBitmap(int width, int height, void*& bits) {
+    // Negative height for rows from top to bottom
+    BITMAPINFO bmi = {};
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = width;
+    bmi.bmiHeader.biHeight = -height;
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    HBITMAP bitmap = CreateDIBSection(nullptr, &bmi, DIB_RGB_COLORS, &bits, nullptr, 0);
+    if (!bitmap) {
+        throw std::runtime_error("Could not create DIB section");
+    }
+    return bitmap;
+}
+
+void Window::startAsyncPresent(PixelFormat format) {
+    if (impl->asyncFrames) stopAsyncPresent();
+
+    impl->asyncFrames = std::make_unique<FrameMailbox>(format);
+    impl->asyncThread = std::thread([this] { impl->runAsyncPresent(); });
+}
+
+void Window::stopAsyncPresent() {
+    if (!impl->asyncFrames) return;
+
+    impl->asyncFrames->stop();
+    impl->asyncThread.join();
+    impl->asyncFrames.reset();
+}
+
+PixelBuffer Window::acquireFrame(int width, int height) {
+    if (!impl->asyncFrames) {
+        throw std::runtime_error("Asynchronous presenting isn't started");
+    }
+    return impl->asyncFrames->acquire(width, height);
+}
+
+void Window::submitFrame() {
+    if (impl->asyncFrames) impl->asyncFrames->submit();
+}
+
+PresentStats Window::getPresentStats() {
+    return impl->asyncFrames ? impl->asyncFrames->getStats() : PresentStats{};
+}
+
+void Window::startCapture(const std::string& path, CaptureFormat format, double frameRate) {
+    throw std::runtime_error("Window capture is unsupported on Win32");
+}
+
+void Window::captureFrame() {}
+void Window::stopCapture() {}
+
+CaptureStats Window::getCaptureStats() {
+    return {};
+}
+
+// GDI has no way to find when a frame reaches the screen
+bool Window::isPresentTimingSupported() {
+    return false;
+}
+
+bool Window::isPresentTimingEnabled() {
+    return false;
+}
+
+void Window::setPresentTimingEnabled(bool enabled) {}
+
+void Window::setPresentVblankHandler(std::function<void(std::uint64_t)> handler) {
+    presentVblankHandler = handler;
+}
+
+std::uint32_t Window::getPresentFrameNumber() {
+    return 0;
+}
+
+void Window::Impl::runAsyncPresent() {
+    // GDI objects can be used from any thread, so the thread has its own
+    // bitmap and draws to the window through its own DC
+    HDC dc = CreateCompatibleDC(nullptr);
+    HBITMAP bitmap = nullptr;
+    HGDIOBJ defaultBitmap = nullptr;
+    void* bits = nullptr;
+    int width = 0, height = 0;
+
+    try {
+        PixelBuffer frame;
+        while (asyncFrames->take(frame)) {
+            if (frame.width > 0 && frame.height > 0) {
+                if (!bitmap || width != frame.width || height != frame.height) {
+                    HBITMAP newBitmap = createBitmap(frame.width, frame.height, bits);
+                    HGDIOBJ previous = SelectObject(dc, newBitmap);
+                    if (bitmap) DeleteObject(bitmap);
+                    else defaultBitmap = previous;
+                    bitmap = newBitmap;
+                    width = frame.width;
+                    height = frame.height;
+                }
+
+                PixelBuffer target;
+                target.data = bits;
+                target.stride = static_cast<std::size_t>(width) * 4;
+                target.width = width;
+                target.height = height;
+                target.format = PixelFormat::Bgrx8888;
+                convertPixels(frame, target);
+
+                HDC windowDc = GetDC(hWnd);
+                BitBlt(windowDc, 0, 0, width, height, dc, 0, 0, SRCCOPY);
+                ReleaseDC(hWnd, windowDc);
+                GdiFlush();
+            }
+            asyncFrames->release();
+        }
+    } catch (...) {
+        asyncFrames->fail(std::current_exception());
+    }
+
+    if (bitmap) {
+        SelectObject(dc, defaultBitmap);
+        DeleteObject(bitmap);
+    }
+    DeleteDC(dc);
+}
+
+bool Window::isCursorLocked() {
+    return impl->cursorLocked;
+}
+
+void Window::setCursorLocked(bool locked) {
+    if (impl->cursorLocked == locked) return;
+    impl->cursorLocked = locked;
+    
+    // ClipCursor confines the cursor, so no recentring is needed
+    if (locked) {
+        impl->clipLockedCursor();
+        ShowCursor(FALSE);
+    } else {
+        ClipCursor(nullptr);
+        ShowCursor(TRUE);
+    }
+
+    impl->rawMotionSamples.clear();
+    impl->updateRawMouseRegistration();
+}
+
+void Window::Impl::updateRawMouseRegistration() {
+    RAWINPUTDEVICE rid = { 0x01, 0x02, 0, hWnd };
+    if (!rawMotionEnabled && !cursorLocked) {
+        rid.dwFlags = RIDEV_REMOVE;
+        rid.hwndTarget = nullptr;
+    }
+    RegisterRawInputDevices(&rid, 1, sizeof(rid));
+}
+
+void Window::Impl::clipLockedCursor() {
+    RECT rect;
+    GetClientRect(hWnd, &rect);
+    MapWindowPoints(hWnd, nullptr, reinterpret_cast<LPPOINT>(&rect), 2);
+    ClipCursor(&rect);
+}
+
 RECT Window::Impl::createWindowRect(WindowSize size, WindowPos pos) {
     RECT rect;
     rect.left = pos.x;
@@ -345,7 +724,17 @@ LRESULT CALLBACK Window::Impl::wndProc(
         window->impl->closeRequested = true;
         return 0;
 
+    // The cursor clip is released whenever another window is activated
+    case WM_ACTIVATE:
+        if (window->impl->cursorLocked) {
+            if (LOWORD(wParam) == WA_INACTIVE) ClipCursor(nullptr);
+            else window->impl->clipLockedCursor();
+        }
+        break;
+
     case WM_SIZE:
+        if (window->impl->cursorLocked) window->impl->clipLockedCursor();
+
         if (window->resizeHandler) {
             ResizeEvent event;
             event.size = { LOWORD(lParam), HIWORD(lParam) };
@@ -355,6 +744,8 @@ LRESULT CALLBACK Window::Impl::wndProc(
         return 0;
 
     case WM_MOVE:
+        if (window->impl->cursorLocked) window->impl->clipLockedCursor();
+
         if (window->moveHandler) {
             MoveEvent event;
             event.pos = { static_cast<short>(LOWORD(lParam)), static_cast<short>(HIWORD(lParam)) };
@@ -363,17 +754,41 @@ LRESULT CALLBACK Window::Impl::wndProc(
 
         return 0;
 
-    case WM_CHAR:
+    case WM_CHAR: {
+        // WM_CHAR carries UTF-16 code units, so characters outside the BMP
+        // arrive as a high surrogate followed by a low surrogate
+        auto unit = static_cast<wchar_t>(wParam);
+        if (IS_HIGH_SURROGATE(unit)) {
+            window->impl->highSurrogate = unit;
+            return 0;
+        }
+
+        char32_t codePoint = unit;
+        if (IS_LOW_SURROGATE(unit)) {
+            wchar_t high = window->impl->highSurrogate;
+            window->impl->highSurrogate = 0;
+
+            // A lone low surrogate isn't a character
+            if (!IS_HIGH_SURROGATE(high)) return 0;
+            codePoint = 0x10000 + ((static_cast<char32_t>(high) - 0xD800) << 10) + (unit - 0xDC00);
+        } else {
+            window->impl->highSurrogate = 0;
+        }
+
         if (window->keyCharHandler) {
             KeyCharEvent event;
-            event.codePoint = static_cast<char32_t>(wParam);
+            event.codePoint = codePoint;
             window->keyCharHandler(event);
         }
+
+        if (window->textInputHandler)
+            appendUtf8(window->impl->pendingText, codePoint);
         
         return 0;
+    }
 
     case WM_MOUSEMOVE:
-        if (window->cursorMoveHandler) {
+        if (window->cursorMoveHandler && !window->impl->cursorLocked) {
             CursorMoveEvent event;
 
             // Supplied coordinates are in client space
@@ -412,14 +827,13 @@ LRESULT CALLBACK Window::Impl::wndProc(
 
         return 0;
     
+    // High resolution wheels and touchpads send fractions of WHEEL_DELTA
     case WM_MOUSEWHEEL:
-        if (window->scrollHandler) {
-            ScrollEvent event;
-            event.vScroll = GET_WHEEL_DELTA_WPARAM(wParam) / WHEEL_DELTA;
-            event.hScroll = 0;
-            window->scrollHandler(event);
-        }
+        window->impl->pendingVScroll += static_cast<double>(GET_WHEEL_DELTA_WPARAM(wParam)) / WHEEL_DELTA;
+        return 0;
 
+    case WM_MOUSEHWHEEL:
+        window->impl->pendingHScroll += static_cast<double>(GET_WHEEL_DELTA_WPARAM(wParam)) / WHEEL_DELTA;
         return 0;
 
     case WM_LBUTTONDOWN:
@@ -486,17 +900,46 @@ LRESULT CALLBACK Window::Impl::wndProc(
                     if (window->keyHandler) window->keyHandler(event);
                 }
                 break;
+            case RIM_TYPEMOUSE:
+                {
+                    // Absolute devices like tablets report positions
+                    const RAWMOUSE& mouse = rawInput.data.mouse;
+                    if (!window->impl->rawMotionEnabled && !window->impl->cursorLocked) break;
+                    if (mouse.usFlags & MOUSE_MOVE_ABSOLUTE) break;
+                    if (mouse.lLastX == 0 && mouse.lLastY == 0) break;
+
+                    RawMotionSample sample;
+                    sample.dx = static_cast<double>(mouse.lLastX);
+                    sample.dy = static_cast<double>(mouse.lLastY);
+                    sample.time = static_cast<std::uint32_t>(GetMessageTime());
+                    window->impl->rawMotionSamples.push_back(sample);
+                }
+                break;
             }
         }
         return 0;
     
-    // Repaint the window white when it's been invalidated
+    // Repaint invalidated areas from the last presented pixel buffer, or white
+    // without one, until the damage event lets the app redraw them
     case WM_PAINT:
         {
             PAINTSTRUCT ps;
             HDC hdc = BeginPaint(hWnd, &ps);
-            FillRect(hdc, &ps.rcPaint, (HBRUSH)(COLOR_WINDOW + 1));
+            const RECT& paint = ps.rcPaint;
+            if (window->impl->bitmap) {
+                BitBlt(
+                    hdc, 
+                    paint.left, paint.top, paint.right - paint.left, paint.bottom - paint.top, 
+                    window->impl->bitmapDc, 
+                    paint.left, paint.top, 
+                    SRCCOPY
+                );
+            } else {
+                FillRect(hdc, &paint, (HBRUSH)(COLOR_WINDOW + 1));
+            }
             EndPaint(hWnd, &ps);
+
+            window->impl->addDamage({ paint.left, paint.top, paint.right - paint.left, paint.bottom - paint.top });
         }
         return 0;
     }
@@ -510,6 +953,27 @@ LRESULT CALLBACK Window::Impl::lowLevelKeyboardProc(
     return nCode;
 }
 
+void Window::Impl::appendUtf8(std::string& string, char32_t codePoint) {
+    if (codePoint <= 0x7F) {
+        string += static_cast<char>(codePoint);
+    } else if (codePoint <= 0x7FF) {
+        string += static_cast<char>(0xC0 | codePoint >> 6);
+        string += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else if (codePoint >= 0xD800 && codePoint <= 0xDFFF) {
+        // Surrogates can't be encoded in valid UTF-8
+        return;
+    } else if (codePoint <= 0xFFFF) {
+        string += static_cast<char>(0xE0 | codePoint >> 12);
+        string += static_cast<char>(0x80 | (codePoint >> 6 & 0x3F));
+        string += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else if (codePoint <= 0x10FFFF) {
+        string += static_cast<char>(0xF0 | codePoint >> 18);
+        string += static_cast<char>(0x80 | (codePoint >> 12 & 0x3F));
+        string += static_cast<char>(0x80 | (codePoint >> 6 & 0x3F));
+        string += static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+}
+
 std::string Window::Impl::wideStringToString(const std::wstring& wstring) {
     int length = WideCharToMultiByte(
         CP_UTF8, 
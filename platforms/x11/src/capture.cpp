@@ -0,0 +1,182 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#include "impl.hpp"
+#include "errortrap.hpp"
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <X11/Xutil.h>
+
+using namespace esd::wnd;
+
+void esd::wnd::Window::startCapture(const std::string& path, CaptureFormat format, double frameRate) {
+    if (impl->captureWriter) stopCapture();
+
+    // Frames keep the size the window has now
+    impl->captureWidth = std::max(impl->width, 1);
+    impl->captureHeight = std::max(impl->height, 1);
+    try {
+        for (auto& target : impl->captureTargets) {
+            target.init(impl->display, impl->screen, impl->window);
+            target.createImage(impl->captureWidth, impl->captureHeight);
+            if (target.pixelFormat == PixelFormat::Unknown) {
+                throw std::runtime_error("Unsupported window pixel format for capture");
+            }
+        }
+        impl->captureWriter = std::make_unique<CaptureWriter>(
+            path, 
+            format, 
+            impl->captureWidth, 
+            impl->captureHeight, 
+            frameRate
+        );
+    } catch (...) {
+        impl->endCapture();
+        throw;
+    }
+
+#ifdef ESD_WND_HAS_XDAMAGE
+    int eventBase, errorBase;
+    if (XDamageQueryExtension(impl->display, &eventBase, &errorBase)) {
+        impl->captureDamage = XDamageCreate(impl->display, impl->window, XDamageReportNonEmpty);
+        impl->captureDamageType = eventBase + XDamageNotify;
+    }
+#endif
+    impl->captureDamaged = true;
+}
+
+void esd::wnd::Window::captureFrame() {
+    if (!impl->captureWriter) return;
+    auto& writer = *impl->captureWriter;
+
+    // Damage events for everything drawn so far only arrive after a round
+    // trip, which is still far cheaper than grabbing
+    if (impl->captureDamageType != -1) {
+        XSync(impl->display, False);
+        XEvent xe;
+        while (XCheckTypedEvent(impl->display, impl->captureDamageType, &xe)) impl->captureDamaged = true;
+        if (!impl->captureDamaged) {
+            writer.repeat(false);
+            return;
+        }
+    }
+
+    int buffer = writer.acquire();
+    if (buffer == -1) {
+        writer.repeat(true);
+        return;
+    }
+
+    // Damage from here on belongs to the next frame
+#ifdef ESD_WND_HAS_XDAMAGE
+    if (impl->captureDamage != None) XDamageSubtract(impl->display, impl->captureDamage, None, None);
+#endif
+    impl->captureDamaged = false;
+
+    PixelBuffer frame;
+    if (!impl->grabCaptureFrame(impl->captureTargets[buffer], frame)) {
+        impl->captureDamaged = true;
+        writer.repeat(true);
+        return;
+    }
+    writer.submit(buffer, frame);
+}
+
+void esd::wnd::Window::stopCapture() {
+    if (!impl->captureWriter) return;
+
+    // Everything is freed even if writing failed
+    std::exception_ptr error;
+    try {
+        impl->captureWriter->stop();
+    } catch (...) {
+        error = std::current_exception();
+    }
+    impl->endCapture();
+    if (error) std::rethrow_exception(error);
+}
+
+CaptureStats esd::wnd::Window::getCaptureStats() {
+    return impl->captureWriter ? impl->captureWriter->getStats() : impl->lastCaptureStats;
+}
+
+bool esd::wnd::Window::Impl::grabCaptureFrame(PresentTarget& target, PixelBuffer& frame) {
+    int grabWidth = std::min(width, captureWidth);
+    int grabHeight = std::min(height, captureHeight);
+    if (grabWidth <= 0 || grabHeight <= 0) return false;
+
+    frame = target.getBuffer();
+    frame.width = grabWidth;
+    frame.height = grabHeight;
+
+    // Grabbing fails while the window isn't viewable, and without a
+    // compositor while it is partly off screen
+    ErrorTrap trap(display);
+
+#ifdef ESD_WND_HAS_XSHM
+    if (target.shmImage) {
+        // The server packs rows for the size it grabs, so smaller grabs go
+        // through an image of their own over the same memory
+        XImage* image = target.image;
+        XImage* cropped = nullptr;
+        if (grabWidth != image->width || grabHeight != image->height) {
+            cropped = XShmCreateImage(
+                display, 
+                DefaultVisual(display, screen), 
+                DefaultDepth(display, screen), 
+                ZPixmap, 
+                image->data, 
+                &target.shmInfo, 
+                grabWidth, 
+                grabHeight
+            );
+            if (!cropped) return false;
+            frame.stride = cropped->bytes_per_line;
+            image = cropped;
+        }
+
+        Status status = XShmGetImage(display, window, image, 0, 0, AllPlanes);
+        if (cropped) {
+            cropped->data = nullptr;
+            XDestroyImage(cropped);
+        }
+        return status && !trap.hasFailed();
+    }
+#endif
+
+    XImage* image = XGetSubImage(display, window, 0, 0, grabWidth, grabHeight, AllPlanes, ZPixmap, target.image, 0, 0);
+    return image && !trap.hasFailed();
+}
+
+void esd::wnd::Window::Impl::endCapture() {
+    // The writer reads the targets until it has stopped
+    if (captureWriter) {
+        lastCaptureStats = captureWriter->getStats();
+        captureWriter.reset();
+    }
+
+#ifdef ESD_WND_HAS_XDAMAGE
+    if (captureDamage != None) XDamageDestroy(display, captureDamage);
+    captureDamage = None;
+#endif
+    captureDamageType = -1;
+    for (auto& target : captureTargets) target.destroy();
+}
@@ -0,0 +1,331 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#include "capturewriter.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <numeric>
+#include <stdexcept>
+#include <unistd.h>
+
+using namespace esd::wnd;
+
+namespace {
+
+// Direct writes must be whole blocks from aligned memory at aligned offsets,
+// which the staging buffer's size and alignment keep them to
+constexpr std::size_t blockSize = 4096;
+constexpr std::size_t stagingSize = 8 << 20;
+
+// Unpack a row of the window's pixels into RGB triplets, black past the end of
+// the row, or for all of it if there is no row
+void unpackRow(const std::uint8_t* in, PixelFormat format, int width, int outWidth, std::uint8_t* rgb) {
+    if (!in) width = 0;
+
+    // Byte offsets of 8 bit channels
+    int r = 0, g = 0, b = 0;
+    switch (format) {
+    case PixelFormat::Bgrx8888: r = 2; g = 1; b = 0; break;
+    case PixelFormat::Rgbx8888: r = 0; g = 1; b = 2; break;
+    case PixelFormat::Xrgb8888: r = 1; g = 2; b = 3; break;
+    case PixelFormat::Xbgr8888: r = 3; g = 2; b = 1; break;
+    default: break;
+    }
+
+    for (int x = 0; x < width; x++) {
+        std::uint8_t* out = rgb + x * 3;
+        if (format == PixelFormat::Rgb565) {
+            std::uint16_t value;
+            std::memcpy(&value, in + x * 2, 2);
+            int r5 = value >> 11, g6 = value >> 5 & 0x3F, b5 = value & 0x1F;
+            out[0] = r5 << 3 | r5 >> 2;
+            out[1] = g6 << 2 | g6 >> 4;
+            out[2] = b5 << 3 | b5 >> 2;
+        } else if (format == PixelFormat::Xrgb2101010) {
+            std::uint32_t value;
+            std::memcpy(&value, in + x * 4, 4);
+            out[0] = value >> 22 & 0xFF;
+            out[1] = value >> 12 & 0xFF;
+            out[2] = value >> 2 & 0xFF;
+        } else {
+            const std::uint8_t* pixel = in + x * 4;
+            out[0] = pixel[r];
+            out[1] = pixel[g];
+            out[2] = pixel[b];
+        }
+    }
+    std::memset(rgb + width * 3, 0, std::size_t(outWidth - width) * 3);
+}
+
+}
+
+CaptureWriter::CaptureWriter(const std::string& path, CaptureFormat format, int width, int height, double frameRate)
+    : format(format), width(width), height(height) {
+    // Frame rates are kept to a thousandth of a frame per second
+    long long rateNumerator = std::llround(frameRate * 1000);
+    long long rateDenominator = 1000;
+    if (rateNumerator <= 0) throw std::runtime_error("Invalid capture frame rate");
+    long long divisor = std::gcd(rateNumerator, rateDenominator);
+    rateNumerator /= divisor;
+    rateDenominator /= divisor;
+
+    // Not every file system supports direct writes
+    int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    direct = false;
+#ifdef O_DIRECT
+    fd = ::open(path.c_str(), flags | O_DIRECT, 0644);
+    direct = fd != -1;
+    if (!direct)
+#endif
+    fd = ::open(path.c_str(), flags, 0644);
+    if (fd == -1) throw std::runtime_error("Could not open capture file " + path);
+
+    staging = static_cast<std::uint8_t*>(std::aligned_alloc(blockSize, stagingSize));
+    if (!staging) {
+        ::close(fd);
+        throw std::runtime_error("Could not allocate capture buffer");
+    }
+
+    // Frames start out black, for repeats before the first one
+    rgbRows.resize(std::size_t(width) * 3 * 2);
+    if (format == CaptureFormat::Y4m) {
+        std::size_t lumaSize = std::size_t(width) * height;
+        std::size_t chromaSize = std::size_t((width + 1) / 2) * ((height + 1) / 2);
+        frameBytes.resize(6 + lumaSize + chromaSize * 2);
+        std::memcpy(frameBytes.data(), "FRAME\n", 6);
+        std::memset(frameBytes.data() + 6, 16, lumaSize);
+        std::memset(frameBytes.data() + 6 + lumaSize, 128, chromaSize * 2);
+
+        char header[128];
+        int length = std::snprintf(
+            header, 
+            sizeof(header), 
+            "YUV4MPEG2 W%d H%d F%lld:%lld Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n", 
+            width, 
+            height, 
+            rateNumerator, 
+            rateDenominator
+        );
+        append(header, length);
+    } else {
+        frameBytes.resize(std::size_t(width) * height * 4);
+    }
+
+    thread = std::thread(&CaptureWriter::run, this);
+}
+
+CaptureWriter::~CaptureWriter() {
+    // Errors are lost if the writer wasn't stopped first
+    try {
+        stop();
+    } catch (...) {}
+    std::free(staging);
+}
+
+int CaptureWriter::acquire() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (int i = 0; i < bufferCount; i++) {
+        if (!busy[i]) return i;
+    }
+    return -1;
+}
+
+void CaptureWriter::submit(int buffer, const PixelBuffer& frame) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (error) std::rethrow_exception(error);
+
+    busy[buffer] = true;
+    queue.push_back({ buffer, frame });
+    entryQueued.notify_one();
+}
+
+void CaptureWriter::repeat(bool dropped) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (error) std::rethrow_exception(error);
+
+    if (dropped) stats.dropped++;
+    else stats.unchanged++;
+    queue.push_back({ -1, {} });
+    entryQueued.notify_one();
+}
+
+void CaptureWriter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        entryQueued.notify_one();
+    }
+    if (thread.joinable()) thread.join();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (error) std::rethrow_exception(error);
+}
+
+CaptureStats CaptureWriter::getStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+void CaptureWriter::run() {
+    try {
+        while (true) {
+            Entry entry;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                entryQueued.wait(lock, [&] { return !queue.empty() || stopping; });
+                if (queue.empty()) break;
+                entry = queue.front();
+                queue.pop_front();
+            }
+
+            // The buffer can be captured into again once converted
+            if (entry.buffer != -1) {
+                convert(entry.frame);
+                std::lock_guard<std::mutex> lock(mutex);
+                busy[entry.buffer] = false;
+            }
+
+            append(frameBytes.data(), frameBytes.size());
+            std::lock_guard<std::mutex> lock(mutex);
+            stats.frames++;
+        }
+
+        flush(true);
+
+        // Direct writes padded the last block
+        if (direct && ::ftruncate(fd, fileSize) != 0) {
+            throw std::runtime_error("Could not write capture file");
+        }
+    } catch (...) {
+        // Nothing is written after an error, so queued buffers are free again
+        std::lock_guard<std::mutex> lock(mutex);
+        error = std::current_exception();
+        queue.clear();
+        std::fill(std::begin(busy), std::end(busy), false);
+    }
+    ::close(fd);
+}
+
+void CaptureWriter::convert(const PixelBuffer& frame) {
+    int frameWidth = std::clamp(frame.width, 0, width);
+    int frameHeight = std::clamp(frame.height, 0, height);
+    auto in = static_cast<const std::uint8_t*>(frame.data);
+    auto getRow = [&](int y) { return y < frameHeight ? in + y * frame.stride : nullptr; };
+
+    if (format == CaptureFormat::Raw) {
+        std::uint8_t* rgb = rgbRows.data();
+        for (int y = 0; y < height; y++) {
+            std::uint8_t* out = frameBytes.data() + std::size_t(y) * width * 4;
+            if (frame.format == PixelFormat::Bgrx8888 && getRow(y)) {
+                std::memcpy(out, getRow(y), std::size_t(frameWidth) * 4);
+                std::memset(out + frameWidth * 4, 0, std::size_t(width - frameWidth) * 4);
+                continue;
+            }
+
+            unpackRow(getRow(y), frame.format, frameWidth, width, rgb);
+            for (int x = 0; x < width; x++) {
+                out[x * 4 + 0] = rgb[x * 3 + 2];
+                out[x * 4 + 1] = rgb[x * 3 + 1];
+                out[x * 4 + 2] = rgb[x * 3 + 0];
+                out[x * 4 + 3] = 0;
+            }
+        }
+        return;
+    }
+
+    // BT.601 limited range in 8.8 fixed point, with chroma from the average of
+    // each 2x2 block
+    int chromaWidth = (width + 1) / 2;
+    int chromaHeight = (height + 1) / 2;
+    std::uint8_t* yPlane = frameBytes.data() + 6;
+    std::uint8_t* uPlane = yPlane + std::size_t(width) * height;
+    std::uint8_t* vPlane = uPlane + std::size_t(chromaWidth) * chromaHeight;
+    std::uint8_t* rows[2] = { rgbRows.data(), rgbRows.data() + width * 3 };
+
+    for (int y = 0; y < height; y += 2) {
+        // The last row of odd heights is paired with itself
+        for (int i = 0; i < 2; i++) {
+            int row = std::min(y + i, height - 1);
+            unpackRow(getRow(row), frame.format, frameWidth, width, rows[i]);
+
+            if (y + i == row) {
+                std::uint8_t* out = yPlane + std::size_t(row) * width;
+                for (int x = 0; x < width; x++) {
+                    const std::uint8_t* rgb = rows[i] + x * 3;
+                    out[x] = ((66 * rgb[0] + 129 * rgb[1] + 25 * rgb[2] + 128) >> 8) + 16;
+                }
+            }
+        }
+
+        std::uint8_t* u = uPlane + std::size_t(y / 2) * chromaWidth;
+        std::uint8_t* v = vPlane + std::size_t(y / 2) * chromaWidth;
+        for (int x = 0; x < chromaWidth; x++) {
+            int x1 = x * 2 * 3;
+            int x2 = std::min(x * 2 + 1, width - 1) * 3;
+            int r = (rows[0][x1 + 0] + rows[0][x2 + 0] + rows[1][x1 + 0] + rows[1][x2 + 0] + 2) >> 2;
+            int g = (rows[0][x1 + 1] + rows[0][x2 + 1] + rows[1][x1 + 1] + rows[1][x2 + 1] + 2) >> 2;
+            int b = (rows[0][x1 + 2] + rows[0][x2 + 2] + rows[1][x1 + 2] + rows[1][x2 + 2] + 2) >> 2;
+            u[x] = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+            v[x] = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+        }
+    }
+}
+
+void CaptureWriter::append(const void* data, std::size_t size) {
+    auto bytes = static_cast<const std::uint8_t*>(data);
+    while (size > 0) {
+        std::size_t count = std::min(size, stagingSize - stagingUsed);
+        std::memcpy(staging + stagingUsed, bytes, count);
+        stagingUsed += count;
+        bytes += count;
+        size -= count;
+        if (stagingUsed == stagingSize) flush(false);
+    }
+}
+
+void CaptureWriter::flush(bool last) {
+    // The last direct write is padded to a whole block, and the file is
+    // truncated back to its real size afterwards
+    std::size_t size = stagingUsed;
+    if (direct && last) {
+        size = (size + blockSize - 1) / blockSize * blockSize;
+        std::memset(staging + stagingUsed, 0, size - stagingUsed);
+    }
+
+    std::size_t written = 0;
+    while (written < size) {
+        ssize_t result = ::write(fd, staging + written, size - written);
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("Could not write capture file");
+        }
+        written += result;
+    }
+
+    fileSize += stagingUsed;
+    stagingUsed = 0;
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.bytesWritten = fileSize;
+}
@@ -0,0 +1,98 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include <eseed/window/window.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace esd::wnd {
+
+// Streams captured frames to a video file from a background thread
+// Frames are captured into buffers owned by the capturing side, which are
+// busy from being submitted until the writer has converted them
+// Output goes through a large aligned staging buffer, written with O_DIRECT
+// where the file system supports it so recordings don't fill the page cache
+class CaptureWriter {
+public:
+    static constexpr int bufferCount = 4;
+
+    // Throws if the file can't be opened
+    CaptureWriter(const std::string& path, CaptureFormat format, int width, int height, double frameRate);
+    CaptureWriter(const CaptureWriter&) = delete;
+    ~CaptureWriter();
+
+    // Index of a buffer that isn't waiting to be written, -1 if all are
+    int acquire();
+
+    // Queue a frame captured into a buffer, rethrowing any error from writing
+    void submit(int buffer, const PixelBuffer& frame);
+
+    // Queue the previous frame again, black if there is none
+    void repeat(bool dropped);
+
+    // Write everything queued and close the file, rethrowing any error from
+    // writing
+    void stop();
+
+    CaptureStats getStats();
+
+private:
+    CaptureFormat format;
+    int width, height;
+
+    int fd;
+    bool direct; // Writes must be whole aligned blocks
+    std::uint8_t* staging;
+    std::size_t stagingUsed = 0;
+    std::uint64_t fileSize = 0;
+
+    // The last frame in the file's format, written again for repeats
+    std::vector<std::uint8_t> frameBytes;
+    std::vector<std::uint8_t> rgbRows; // Two rows, for chroma subsampling
+
+    struct Entry {
+        int buffer; // -1 to repeat the previous frame
+        PixelBuffer frame;
+    };
+    std::deque<Entry> queue;
+    bool busy[bufferCount] = {};
+
+    std::mutex mutex;
+    std::condition_variable entryQueued;
+    bool stopping = false;
+    std::exception_ptr error;
+    CaptureStats stats = {};
+    std::thread thread;
+
+    void run();
+    void convert(const PixelBuffer& frame);
+    void append(const void* data, std::size_t size);
+    void flush(bool last);
+};
+
+}
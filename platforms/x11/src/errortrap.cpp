@@ -0,0 +1,59 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#include "errortrap.hpp"
+
+using namespace esd::wnd;
+
+namespace {
+
+std::mutex trapMutex;
+
+// State of the current trap, only touched while holding the mutex
+XErrorHandler previousHandler;
+Display* trapDisplay;
+unsigned long firstSerial;
+bool failed;
+
+int onError(Display* display, XErrorEvent* error) {
+    if (display != trapDisplay || error->serial < firstSerial) {
+        return previousHandler ? previousHandler(display, error) : 0;
+    }
+    failed = true;
+    return 0;
+}
+
+}
+
+ErrorTrap::ErrorTrap(Display* display) : lock(trapMutex) {
+    trapDisplay = display;
+    firstSerial = NextRequest(display);
+    failed = false;
+    previousHandler = XSetErrorHandler(onError);
+}
+
+ErrorTrap::~ErrorTrap() {
+    XSetErrorHandler(previousHandler);
+    trapDisplay = nullptr;
+}
+
+bool ErrorTrap::hasFailed() {
+    return failed;
+}
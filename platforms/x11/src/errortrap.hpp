@@ -0,0 +1,47 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include <X11/Xlib.h>
+#include <mutex>
+
+namespace esd::wnd {
+
+// Catches X errors from requests made on a connection while the trap exists,
+// for requests that are expected to fail in some cases, instead of the default
+// handler exiting
+// Error handlers are process wide, so traps are serialized between threads,
+// and errors from other requests or connections go to the previous handler
+// Errors only arrive once the server has replied, so the request must be
+// followed by a round trip before checking
+class ErrorTrap {
+public:
+    explicit ErrorTrap(Display* display);
+    ErrorTrap(const ErrorTrap&) = delete;
+    ~ErrorTrap();
+
+    bool hasFailed();
+
+private:
+    std::unique_lock<std::mutex> lock;
+};
+
+}
@@ -0,0 +1,603 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#include "evdev.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+using namespace esd::wnd;
+
+namespace {
+
+constexpr const char* inputDir = "/dev/input";
+
+// epoll data for the inotify descriptor, pads use their id
+constexpr std::uint32_t hotplugTag = 0xFFFFFFFF;
+
+constexpr std::size_t bitsToLongs(std::size_t bits) {
+    return (bits + sizeof(unsigned long) * 8 - 1) / (sizeof(unsigned long) * 8);
+}
+
+bool testBit(const unsigned long* bits, unsigned int bit) {
+    return bits[bit / (sizeof(unsigned long) * 8)] >> (bit % (sizeof(unsigned long) * 8)) & 1;
+}
+
+GamepadButton toGamepadButton(unsigned int code) {
+    switch (code) {
+    case BTN_SOUTH: return GamepadButton::South;
+    case BTN_EAST: return GamepadButton::East;
+    case BTN_WEST: return GamepadButton::West;
+    case BTN_NORTH: return GamepadButton::North;
+    case BTN_TL: return GamepadButton::LeftBumper;
+    case BTN_TR: return GamepadButton::RightBumper;
+    case BTN_SELECT: return GamepadButton::Back;
+    case BTN_START: return GamepadButton::Start;
+    case BTN_MODE: return GamepadButton::Guide;
+    case BTN_THUMBL: return GamepadButton::LeftStick;
+    case BTN_THUMBR: return GamepadButton::RightStick;
+    case BTN_DPAD_UP: return GamepadButton::DPadUp;
+    case BTN_DPAD_DOWN: return GamepadButton::DPadDown;
+    case BTN_DPAD_LEFT: return GamepadButton::DPadLeft;
+    case BTN_DPAD_RIGHT: return GamepadButton::DPadRight;
+    default: return GamepadButton::Count;
+    }
+}
+
+GamepadAxis toGamepadAxis(unsigned int code) {
+    switch (code) {
+    case ABS_X: return GamepadAxis::LeftX;
+    case ABS_Y: return GamepadAxis::LeftY;
+    case ABS_RX: return GamepadAxis::RightX;
+    case ABS_RY: return GamepadAxis::RightY;
+    case ABS_Z: return GamepadAxis::LeftTrigger;
+    case ABS_RZ: return GamepadAxis::RightTrigger;
+    default: return GamepadAxis::Count;
+    }
+}
+
+void setButton(GamepadState& state, GamepadButton button, bool down) {
+    std::uint32_t bit = std::uint32_t(1) << static_cast<int>(button);
+    if (down) state.buttons |= bit;
+    else state.buttons &= ~bit;
+}
+
+bool isTrigger(GamepadAxis axis) {
+    return axis == GamepadAxis::LeftTrigger || axis == GamepadAxis::RightTrigger;
+}
+
+bool isHat(unsigned int code) {
+    return code >= ABS_HAT0X && code <= ABS_HAT3Y;
+}
+
+// Targets of SDL mapping fields, a/b/x/y are named by Xbox layout
+struct MappingTarget { std::string_view name; bool axis; int index; };
+constexpr MappingTarget mappingTargets[] = {
+    { "a", false, static_cast<int>(GamepadButton::South) },
+    { "b", false, static_cast<int>(GamepadButton::East) },
+    { "x", false, static_cast<int>(GamepadButton::West) },
+    { "y", false, static_cast<int>(GamepadButton::North) },
+    { "leftshoulder", false, static_cast<int>(GamepadButton::LeftBumper) },
+    { "rightshoulder", false, static_cast<int>(GamepadButton::RightBumper) },
+    { "back", false, static_cast<int>(GamepadButton::Back) },
+    { "start", false, static_cast<int>(GamepadButton::Start) },
+    { "guide", false, static_cast<int>(GamepadButton::Guide) },
+    { "leftstick", false, static_cast<int>(GamepadButton::LeftStick) },
+    { "rightstick", false, static_cast<int>(GamepadButton::RightStick) },
+    { "dpup", false, static_cast<int>(GamepadButton::DPadUp) },
+    { "dpdown", false, static_cast<int>(GamepadButton::DPadDown) },
+    { "dpleft", false, static_cast<int>(GamepadButton::DPadLeft) },
+    { "dpright", false, static_cast<int>(GamepadButton::DPadRight) },
+    { "leftx", true, static_cast<int>(GamepadAxis::LeftX) },
+    { "lefty", true, static_cast<int>(GamepadAxis::LeftY) },
+    { "rightx", true, static_cast<int>(GamepadAxis::RightX) },
+    { "righty", true, static_cast<int>(GamepadAxis::RightY) },
+    { "lefttrigger", true, static_cast<int>(GamepadAxis::LeftTrigger) },
+    { "righttrigger", true, static_cast<int>(GamepadAxis::RightTrigger) }
+};
+
+// Parse a decimal number from the start of text, removing it
+bool parseNumber(std::string_view& text, unsigned int& out) {
+    if (text.empty() || text[0] < '0' || text[0] > '9') return false;
+    out = 0;
+    while (!text.empty() && text[0] >= '0' && text[0] <= '9') {
+        out = out * 10 + (text[0] - '0');
+        text.remove_prefix(1);
+    }
+    return true;
+}
+
+}
+
+esd::wnd::Gamepads::Gamepads() {
+    impl = std::make_unique<Impl>();
+
+    impl->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (impl->epollFd == -1) {
+        throw std::runtime_error("Could not create epoll set for gamepads");
+    }
+
+    // Hotplugging is optional, the pads found now still work without it
+    impl->inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (impl->inotifyFd != -1) {
+        if (inotify_add_watch(impl->inotifyFd, inputDir, IN_CREATE | IN_ATTRIB | IN_DELETE) == -1) {
+            ::close(impl->inotifyFd);
+            impl->inotifyFd = -1;
+        } else {
+            epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.u32 = hotplugTag;
+            epoll_ctl(impl->epollFd, EPOLL_CTL_ADD, impl->inotifyFd, &event);
+        }
+    }
+
+    // Watch before scanning, so pads plugged in between aren't missed
+    DIR* dir = opendir(inputDir);
+    if (dir) {
+        while (dirent* entry = readdir(dir)) {
+            if (std::strncmp(entry->d_name, "event", 5) != 0) continue;
+            impl->openPad(std::string(inputDir) + "/" + entry->d_name, true);
+        }
+        closedir(dir);
+    }
+}
+
+esd::wnd::Gamepads::~Gamepads() {
+    for (auto& pad : impl->pads) {
+        if (pad.fd != -1) ::close(pad.fd);
+    }
+    if (impl->inotifyFd != -1) ::close(impl->inotifyFd);
+    ::close(impl->epollFd);
+}
+
+void esd::wnd::Gamepads::poll() {
+    // Level triggered, so pads not fully read in one batch are returned again
+    epoll_event events[16];
+    int eventCount;
+    do {
+        eventCount = epoll_wait(impl->epollFd, events, 16, 0);
+        for (int i = 0; i < eventCount; i++) {
+            if (events[i].data.u32 == hotplugTag) impl->handleHotplug();
+            else impl->readPad(static_cast<int>(events[i].data.u32));
+        }
+    } while (eventCount == 16);
+
+    for (std::size_t id = 0; id < impl->pads.size(); id++) {
+        if (impl->pads[id].fd != -1 && impl->pads[id].replay) impl->readPad(static_cast<int>(id));
+    }
+
+    if (!impl->pendingConnects.empty()) {
+        if (connectHandler) {
+            for (const auto& event : impl->pendingConnects) connectHandler(event);
+        }
+        impl->pendingConnects.clear();
+    }
+}
+
+int esd::wnd::Gamepads::open(const std::string& path) {
+    int id = impl->openPad(path, false);
+    if (id == -1) {
+        throw std::runtime_error("Could not open gamepad " + path);
+    }
+    return id;
+}
+
+std::size_t esd::wnd::Gamepads::getCount() {
+    return impl->states.size();
+}
+
+bool esd::wnd::Gamepads::isConnected(int id) {
+    return id >= 0 && std::size_t(id) < impl->pads.size() && impl->pads[id].fd != -1;
+}
+
+std::string esd::wnd::Gamepads::getName(int id) {
+    return isConnected(id) ? impl->pads[id].name : std::string();
+}
+
+std::string esd::wnd::Gamepads::getGuid(int id) {
+    return isConnected(id) ? impl->pads[id].guid : std::string();
+}
+
+void esd::wnd::Gamepads::loadMappings(const std::string& path) {
+    impl->mappings.load(path);
+
+    for (std::size_t id = 0; id < impl->pads.size(); id++) {
+        if (impl->pads[id].fd == -1) continue;
+        impl->bindPad(static_cast<int>(id));
+        impl->states[id] = {};
+        impl->resync(static_cast<int>(id));
+    }
+}
+
+const GamepadState& esd::wnd::Gamepads::getState(int id) {
+    return impl->states.at(id);
+}
+
+const GamepadState* esd::wnd::Gamepads::getStates() {
+    return impl->states.data();
+}
+
+int esd::wnd::Gamepads::Impl::openPad(const std::string& path, bool requireGamepad) {
+    for (const auto& pad : pads) {
+        if (pad.fd != -1 && pad.path == path) return -1;
+    }
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd == -1) return -1;
+
+    // Recordings fail every evdev ioctl, and are assumed to be a gamepad
+    unsigned long keyBits[bitsToLongs(KEY_CNT)] = {};
+    bool replay = ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keyBits)), keyBits) == -1;
+    if (replay && requireGamepad) {
+        ::close(fd);
+        return -1;
+    }
+    if (!replay && requireGamepad && !testBit(keyBits, BTN_GAMEPAD) && !testBit(keyBits, BTN_JOYSTICK)) {
+        ::close(fd);
+        return -1;
+    }
+
+    int id = 0;
+    while (std::size_t(id) < pads.size() && pads[id].fd != -1) id++;
+    if (std::size_t(id) == pads.size()) {
+        pads.emplace_back();
+        states.emplace_back();
+    }
+
+    Pad& pad = pads[id];
+    pad.fd = fd;
+    pad.path = path;
+    pad.replay = replay;
+    pad.dropped = false;
+    states[id] = {};
+
+    char name[256] = {};
+    if (!replay && ioctl(fd, EVIOCGNAME(sizeof(name) - 1), name) >= 0) pad.name = name;
+    else pad.name = path;
+
+    // Same layout as SDL's Linux GUIDs: bus, vendor, product and version as
+    // little endian 16 bit values, each followed by 16 zero bits
+    input_id inputId;
+    pad.guid.clear();
+    if (!replay && ioctl(fd, EVIOCGID, &inputId) >= 0) {
+        char guid[33];
+        std::uint16_t parts[4] = { inputId.bustype, inputId.vendor, inputId.product, inputId.version };
+        for (int i = 0; i < 4; i++) {
+            std::snprintf(guid + i * 8, 9, "%02x%02x0000", parts[i] & 0xFF, parts[i] >> 8);
+        }
+        pad.guid = guid;
+    }
+
+    // Without ranges from the device, assume the ones most pads (and the xpad
+    // driver) use
+    for (unsigned int code = 0; code < ABS_CNT; code++) {
+        if (isHat(code)) pad.ranges[code] = { -1, 1 };
+        else if (code == ABS_Z || code == ABS_RZ) pad.ranges[code] = { 0, 255 };
+        else pad.ranges[code] = { -32768, 32767 };
+    }
+
+    bindPad(id);
+
+    if (!replay) {
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.u32 = static_cast<std::uint32_t>(id);
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+        resync(id);
+    }
+
+    pendingConnects.push_back({ id, true });
+    return id;
+}
+
+void esd::wnd::Gamepads::Impl::closePad(int id) {
+    Pad& pad = pads[id];
+    if (!pad.replay) epoll_ctl(epollFd, EPOLL_CTL_DEL, pad.fd, nullptr);
+    ::close(pad.fd);
+    pad.fd = -1;
+    pad.path.clear();
+    states[id] = {};
+    pendingConnects.push_back({ id, false });
+}
+
+void esd::wnd::Gamepads::Impl::readPad(int id) {
+    input_event events[64];
+    while (pads[id].fd != -1) {
+        ssize_t size = read(pads[id].fd, events, sizeof(events));
+        if (size == -1) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN) closePad(id); // ENODEV once unplugged
+            return;
+        }
+
+        // End of a recording, which stays connected with its last state
+        if (size == 0) return;
+
+        std::size_t eventCount = std::size_t(size) / sizeof(input_event);
+        if (pads[id].replay) {
+            // Recordings step one report per poll, so every state in them is
+            // seen, and the rest is read again next poll
+            for (std::size_t i = 0; i < eventCount; i++) {
+                handleInput(id, events[i]);
+                if (events[i].type != EV_SYN || events[i].code != SYN_REPORT) continue;
+                lseek(pads[id].fd, -(size - off_t((i + 1) * sizeof(input_event))), SEEK_CUR);
+                return;
+            }
+        } else {
+            for (std::size_t i = 0; i < eventCount; i++) handleInput(id, events[i]);
+        }
+
+        // Leave a truncated record in a recording to be read again once it's
+        // complete
+        if (std::size_t(size) % sizeof(input_event) != 0) {
+            lseek(pads[id].fd, -(size % off_t(sizeof(input_event))), SEEK_CUR);
+            return;
+        }
+    }
+}
+
+void esd::wnd::Gamepads::Impl::handleInput(int id, const input_event& event) {
+    Pad& pad = pads[id];
+
+    if (event.type == EV_SYN) {
+        if (event.code == SYN_DROPPED) pad.dropped = true;
+        else if (event.code == SYN_REPORT && pad.dropped) resync(id);
+        return;
+    }
+
+    // Events up to the report after a drop are incomplete, the resync covers
+    // them
+    if (pad.dropped) return;
+
+    if (event.type == EV_KEY && event.code < KEY_CNT) applyKey(id, event.code, event.value);
+    else if (event.type == EV_ABS && event.code < ABS_CNT) applyAbs(id, event.code, event.value);
+}
+
+void esd::wnd::Gamepads::Impl::resync(int id) {
+    Pad& pad = pads[id];
+    pad.dropped = false;
+    if (pad.replay) return;
+
+    unsigned long keyBits[bitsToLongs(KEY_CNT)] = {};
+    if (ioctl(pad.fd, EVIOCGKEY(sizeof(keyBits)), keyBits) >= 0) {
+        for (unsigned int code = 0; code < KEY_CNT; code++) {
+            if (pad.keyBindings[code].target != Binding::Target::Unbound) applyKey(id, code, testBit(keyBits, code));
+        }
+    }
+
+    for (unsigned int code = 0; code < ABS_CNT; code++) {
+        const AbsBindings& bindings = pad.absBindings[code];
+        if (
+            bindings.full.target == Binding::Target::Unbound
+            && bindings.negative.target == Binding::Target::Unbound
+            && bindings.positive.target == Binding::Target::Unbound
+        ) continue;
+
+        input_absinfo info;
+        if (ioctl(pad.fd, EVIOCGABS(code), &info) == -1) continue;
+        pad.ranges[code] = { info.minimum, info.maximum };
+        applyAbs(id, code, info.value);
+    }
+}
+
+void esd::wnd::Gamepads::Impl::bindPad(int id) {
+    Pad& pad = pads[id];
+    std::fill(std::begin(pad.keyBindings), std::end(pad.keyBindings), Binding());
+    std::fill(std::begin(pad.absBindings), std::end(pad.absBindings), AbsBindings());
+
+    std::string_view mapping = pad.guid.empty() ? std::string_view() : mappings.find(pad.guid);
+    if (!mapping.empty()) {
+        parseMapping(pad, mapping);
+        return;
+    }
+
+    // Standard evdev gamepad layout
+    for (unsigned int code = 0; code < KEY_CNT; code++) {
+        GamepadButton button = toGamepadButton(code);
+        if (button == GamepadButton::Count) continue;
+        pad.keyBindings[code].target = Binding::Target::Button;
+        pad.keyBindings[code].index = static_cast<std::uint8_t>(button);
+    }
+
+    // Digital triggers act as fully pressed analog ones
+    pad.keyBindings[BTN_TL2].target = Binding::Target::Axis;
+    pad.keyBindings[BTN_TL2].index = static_cast<std::uint8_t>(GamepadAxis::LeftTrigger);
+    pad.keyBindings[BTN_TR2].target = Binding::Target::Axis;
+    pad.keyBindings[BTN_TR2].index = static_cast<std::uint8_t>(GamepadAxis::RightTrigger);
+
+    for (unsigned int code = 0; code < ABS_CNT; code++) {
+        GamepadAxis axis = toGamepadAxis(code);
+        if (axis == GamepadAxis::Count) continue;
+        pad.absBindings[code].full.target = Binding::Target::Axis;
+        pad.absBindings[code].full.index = static_cast<std::uint8_t>(axis);
+    }
+
+    // The first hat is the d-pad
+    auto bindHat = [&](Binding& binding, GamepadButton button) {
+        binding.target = Binding::Target::Button;
+        binding.index = static_cast<std::uint8_t>(button);
+    };
+    bindHat(pad.absBindings[ABS_HAT0X].negative, GamepadButton::DPadLeft);
+    bindHat(pad.absBindings[ABS_HAT0X].positive, GamepadButton::DPadRight);
+    bindHat(pad.absBindings[ABS_HAT0Y].negative, GamepadButton::DPadUp);
+    bindHat(pad.absBindings[ABS_HAT0Y].positive, GamepadButton::DPadDown);
+}
+
+void esd::wnd::Gamepads::Impl::parseMapping(Pad& pad, std::string_view mapping) {
+    unsigned long keyBits[bitsToLongs(KEY_CNT)] = {};
+    unsigned long absBits[bitsToLongs(ABS_CNT)] = {};
+    ioctl(pad.fd, EVIOCGBIT(EV_KEY, sizeof(keyBits)), keyBits);
+    ioctl(pad.fd, EVIOCGBIT(EV_ABS, sizeof(absBits)), absBits);
+
+    // Joystick buttons come first, then anything before them
+    std::vector<unsigned int> buttonCodes;
+    for (unsigned int code = BTN_JOYSTICK; code < KEY_CNT; code++) {
+        if (testBit(keyBits, code)) buttonCodes.push_back(code);
+    }
+    for (unsigned int code = 0; code < BTN_JOYSTICK; code++) {
+        if (testBit(keyBits, code)) buttonCodes.push_back(code);
+    }
+
+    // Hats are numbered separately from other axes
+    std::vector<unsigned int> axisCodes;
+    std::vector<unsigned int> hatCodes;
+    for (unsigned int code = 0; code < ABS_CNT; code++) {
+        if (!isHat(code)) {
+            if (testBit(absBits, code)) axisCodes.push_back(code);
+        } else if ((code - ABS_HAT0X) % 2 == 0 && (testBit(absBits, code) || testBit(absBits, code + 1))) {
+            hatCodes.push_back(code);
+        }
+    }
+
+    while (!mapping.empty()) {
+        std::string_view field = mapping.substr(0, mapping.find(','));
+        mapping.remove_prefix(std::min(mapping.size(), field.size() + 1));
+
+        std::size_t colon = field.find(':');
+        if (colon == std::string_view::npos) continue;
+        std::string_view targetName = field.substr(0, colon);
+        std::string_view source = field.substr(colon + 1);
+
+        // Targets can be half of a stick, e.g. +leftx
+        Binding binding;
+        if (!targetName.empty() && (targetName[0] == '+' || targetName[0] == '-')) {
+            binding.half = targetName[0] == '+' ? 1 : -1;
+            targetName.remove_prefix(1);
+        }
+
+        // Unknown targets include fields like platform
+        auto target = std::find_if(std::begin(mappingTargets), std::end(mappingTargets), 
+            [&](const MappingTarget& target) { return target.name == targetName; });
+        if (target == std::end(mappingTargets)) continue;
+        binding.target = target->axis ? Binding::Target::Axis : Binding::Target::Button;
+        binding.index = static_cast<std::uint8_t>(target->index);
+
+        // Sources can be half of an axis, e.g. -a1, and inverted, e.g. a2~
+        char sourceHalf = 0;
+        if (!source.empty() && (source[0] == '+' || source[0] == '-')) {
+            sourceHalf = source[0];
+            source.remove_prefix(1);
+        }
+        if (!source.empty() && source.back() == '~') {
+            binding.invert = true;
+            source.remove_suffix(1);
+        }
+        if (source.empty()) continue;
+
+        char type = source[0];
+        source.remove_prefix(1);
+        unsigned int number;
+        if (!parseNumber(source, number)) continue;
+
+        if (type == 'b' && number < buttonCodes.size()) {
+            pad.keyBindings[buttonCodes[number]] = binding;
+        } else if (type == 'a' && number < axisCodes.size()) {
+            AbsBindings& bindings = pad.absBindings[axisCodes[number]];
+            if (sourceHalf == '+') bindings.positive = binding;
+            else if (sourceHalf == '-') bindings.negative = binding;
+            else bindings.full = binding;
+        } else if (type == 'h' && number < hatCodes.size() && !source.empty() && source[0] == '.') {
+            // Hat directions are a mask of up (1), right (2), down (4) and
+            // left (8)
+            source.remove_prefix(1);
+            unsigned int direction;
+            if (!parseNumber(source, direction)) continue;
+
+            AbsBindings& x = pad.absBindings[hatCodes[number]];
+            AbsBindings& y = pad.absBindings[hatCodes[number] + 1];
+            if (direction == 1) y.negative = binding;
+            else if (direction == 2) x.positive = binding;
+            else if (direction == 4) y.positive = binding;
+            else if (direction == 8) x.negative = binding;
+        }
+    }
+}
+
+void esd::wnd::Gamepads::Impl::applyKey(int id, unsigned int code, int value) {
+    applyBinding(states[id], pads[id].keyBindings[code], value != 0 ? 1.0f : 0.0f);
+}
+
+void esd::wnd::Gamepads::Impl::applyAbs(int id, unsigned int code, int value) {
+    const AxisRange& range = pads[id].ranges[code];
+    const AbsBindings& bindings = pads[id].absBindings[code];
+    if (range.max <= range.min) return;
+
+    if (bindings.full.target != Binding::Target::Unbound) {
+        float full = float(value - range.min) / float(range.max - range.min);
+        applyBinding(states[id], bindings.full, std::clamp(full, 0.0f, 1.0f));
+    }
+
+    float center = (float(range.min) + float(range.max)) / 2.0f;
+    if (bindings.negative.target != Binding::Target::Unbound) {
+        float negative = (center - float(value)) / (center - float(range.min));
+        applyBinding(states[id], bindings.negative, std::clamp(negative, 0.0f, 1.0f));
+    }
+    if (bindings.positive.target != Binding::Target::Unbound) {
+        float positive = (float(value) - center) / (float(range.max) - center);
+        applyBinding(states[id], bindings.positive, std::clamp(positive, 0.0f, 1.0f));
+    }
+}
+
+void esd::wnd::Gamepads::Impl::applyBinding(GamepadState& state, const Binding& binding, float value) {
+    if (binding.invert) value = 1.0f - value;
+
+    if (binding.target == Binding::Target::Button) {
+        setButton(state, static_cast<GamepadButton>(binding.index), value > 0.5f);
+    } else if (binding.target == Binding::Target::Axis) {
+        float& axis = state.axes[binding.index];
+        if (isTrigger(static_cast<GamepadAxis>(binding.index))) axis = value;
+        else if (binding.half != 0) axis = binding.half * value;
+        else axis = value * 2.0f - 1.0f;
+    }
+}
+
+void esd::wnd::Gamepads::Impl::handleHotplug() {
+    alignas(inotify_event) char buffer[4096];
+    for (;;) {
+        ssize_t size = read(inotifyFd, buffer, sizeof(buffer));
+        if (size == -1 && errno == EINTR) continue;
+        if (size <= 0) return;
+
+        for (char* next = buffer; next < buffer + size;) {
+            auto event = reinterpret_cast<inotify_event*>(next);
+            next += sizeof(inotify_event) + event->len;
+            if (event->len == 0 || std::strncmp(event->name, "event", 5) != 0) continue;
+
+            std::string path = std::string(inputDir) + "/" + event->name;
+            if (event->mask & IN_DELETE) {
+                for (std::size_t id = 0; id < pads.size(); id++) {
+                    if (pads[id].fd != -1 && pads[id].path == path) closePad(static_cast<int>(id));
+                }
+            } else {
+                // Nodes are usually created before udev makes them readable,
+                // so opening is retried when their attributes change
+                openPad(path, true);
+            }
+        }
+    }
+}
@@ -0,0 +1,115 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include "mappingdb.hpp"
+#include <eseed/window/gamepad.hpp>
+#include <linux/input.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Gamepads read straight from evdev devices, all waited on through one epoll
+// set along with an inotify watch on /dev/input for hotplugging
+class esd::wnd::Gamepads::Impl {
+public:
+    int epollFd = -1;
+    int inotifyFd = -1; // -1 if hotplugging isn't available
+
+    struct AxisRange { int min, max; };
+
+    // How an evdev input drives a button or axis of the state
+    // Inputs are first turned into a value from 0 to 1: key presses are 0 or
+    // 1, absolute axes cover their range or, for half bindings, the distance
+    // from their center towards one end
+    struct Binding {
+        enum struct Target : std::uint8_t { Unbound, Button, Axis };
+        Target target = Target::Unbound;
+        std::uint8_t index = 0; // GamepadButton or GamepadAxis
+        std::int8_t half = 0; // For sticks, 1 or -1 to only drive one direction
+        bool invert = false;
+    };
+    struct AbsBindings { Binding full, negative, positive; };
+
+    struct Pad {
+        int fd = -1; // -1 if the id is free
+        std::string path;
+        std::string name;
+
+        // Regular files of recorded events can't be added to an epoll set, so
+        // they are read on every poll instead
+        bool replay;
+
+        // Set after the kernel dropped events, until the next report when the
+        // state is read back from the device
+        bool dropped;
+
+        AxisRange ranges[ABS_CNT];
+
+        // SDL-style GUID, empty for recordings
+        std::string guid;
+
+        // From the pad's entry in the mapping database, or the standard evdev
+        // gamepad layout if it has none
+        Binding keyBindings[KEY_CNT];
+        AbsBindings absBindings[ABS_CNT];
+    };
+    std::vector<Pad> pads;
+
+    // Packed state of every id, returned directly from getStates()
+    std::vector<GamepadState> states;
+
+    // Connection changes to report on the next poll
+    std::vector<GamepadConnectEvent> pendingConnects;
+
+    GamepadMappingDb mappings;
+
+    // Open a device and add it to the epoll set
+    // Devices found by scanning must look like a gamepad, anything opened
+    // explicitly is accepted
+    // Returns the id, or -1 if the device couldn't be used
+    int openPad(const std::string& path, bool requireGamepad);
+    void closePad(int id);
+
+    // Read every pending event from a pad without blocking
+    void readPad(int id);
+    void handleInput(int id, const input_event& event);
+
+    // Set up how the pad's inputs drive its state
+    void bindPad(int id);
+
+    // Parse the fields of an SDL mapping into bindings
+    // Buttons, axes and hats are numbered in the order SDL assigns them to the
+    // codes the device supports
+    void parseMapping(Pad& pad, std::string_view mapping);
+
+    void applyKey(int id, unsigned int code, int value);
+    void applyAbs(int id, unsigned int code, int value);
+    static void applyBinding(GamepadState& state, const Binding& binding, float value);
+
+    // Read the full state back from the device, after events were dropped
+    void resync(int id);
+
+    // Open and close pads as device nodes are created, have their permissions
+    // changed (e.g. by udev after creation) and are deleted
+    void handleHotplug();
+};
@@ -20,8 +20,30 @@
 
 #pragma once
 
+#include "capturewriter.hpp"
+#include "framemailbox.hpp"
+#include "keytable.hpp"
 #include <eseed/window/window.hpp>
 #include <X11/Xlib.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef ESD_WND_HAS_XSHM
+#include "shmarena.hpp"
+#include <X11/extensions/XShm.h>
+#endif
+
+#ifdef ESD_WND_HAS_XINPUT2
+#include <X11/extensions/XInput2.h>
+#endif
+
+#ifdef ESD_WND_HAS_XDAMAGE
+#include <X11/extensions/Xdamage.h>
+#endif
 
 class esd::wnd::Window::Impl {
 public:
@@ -31,12 +53,58 @@ public:
     ::Window window;
     bool closeRequested;
     bool cursorInWindow;
+    bool focused;
+
+    // Visibility from the events that affect it, combined into the visibility
+    // delivered at the end of each poll
+    bool mapped = false;
+    int visibilityState = VisibilityUnobscured;
+    bool wmHidden = false; // _NET_WM_STATE_HIDDEN, set by the WM while minimized
+    Visibility visibility = Visibility::Minimized;
+
+    // Check the window's _NET_WM_STATE for a state
+    bool hasWmState(Atom state);
+
+    FullscreenMode fullscreenMode = FullscreenMode::Windowed;
+
+    // Ask the compositor to stop compositing the window, or leave it to decide
+    void setBypassCompositor(bool bypass);
+
+    // The monitor containing a point on the root window, the first monitor if
+    // none do, or the whole screen without RandR
+    Rect getMonitorRect(int x, int y);
 
     // For finding which values (pos, size) changed since last time
     XConfigureEvent lastConfigure;
 
+    // Size from the last ConfigureNotify, available without a round trip
+    int width, height;
+
     XIM im;
     XIC ic;
+
+    // Whether a real input method (not just the built-in @im=none one) is
+    // attached, otherwise key presses are translated through the key table
+    bool hasInputMethod;
+
+    // Set while the input method is composing a sequence started by a key the
+    // key table can't translate, such as a dead key
+    bool composing = false;
+
+    // Input method callbacks for inline pre-edit, which must outlive the
+    // input context
+    XICCallback preeditStartCallback;
+    XIMCallback preeditDoneCallback;
+    XIMCallback preeditDrawCallback;
+    XIMCallback preeditCaretCallback;
+    std::size_t preeditLength = 0; // In code points
+    std::size_t preeditCaret = 0;
+    std::string preeditText;
+
+    // Reused buffers for text input, so typing doesn't allocate
+    std::vector<char> lookupBuffer = std::vector<char>(64);
+    std::vector<char32_t> codePoints;
+    std::string pendingText; // Text committed during the current poll
     Atom WM_DELETE_WINDOW;
     Atom _NET_WM_NAME;
     Atom _NET_WM_STATE_FULLSCREEN;
@@ -44,13 +112,293 @@ public:
     Atom _NET_MOVERESIZE_WINDOW;
     Atom _NET_WM_STATE;
     Atom UTF8_STRING;
+    Atom _NET_WM_STATE_HIDDEN;
+    Atom _NET_WM_BYPASS_COMPOSITOR;
+    Atom _NET_WM_CM_Sn; // For this window's screen
     constexpr static Atom _NET_WM_STATE_REMOVE = 0;
     constexpr static Atom _NET_WM_STATE_ADD = 1;
     constexpr static Atom _NET_WM_STATE_TOGGLE = 2;
 
-    std::vector<Key> esdKeyTable;
-    std::vector<unsigned int> x11KeyTable;
+    // XInput 2 state, the opcode is -1 if the extension isn't available
+    int xiOpcode = -1;
+    int xiMinorVersion;
+    std::vector<int> absolutePointers; // Pointer devices with absolute axes
+    bool rawMotionEnabled;
+    std::vector<RawMotionSample> rawMotionSamples; // Reused between polls
+
+    // Scrolling accumulated during the current poll
+    double pendingVScroll;
+    double pendingHScroll;
+
+    // Scroll valuators of XInput 2.1 devices, for smooth scrolling
+    // Values are absolute, so the last value of each is kept to find deltas
+    struct ScrollValuator {
+        int deviceId;
+        int number;
+        bool vertical;
+        double increment;
+        double value;
+        bool valueValid;
+    };
+    std::vector<ScrollValuator> scrollValuators;
+
+    // Valuator reporting an axis, with its range for normalizing
+    struct ValuatorRange {
+        int number = -1; // -1 if the device doesn't report the axis
+        double min, max;
+    };
+
+    // Touch devices with the valuator used for pressure, if any
+    struct TouchDevice {
+        int deviceId;
+        ValuatorRange pressure;
+    };
+    std::vector<TouchDevice> touchDevices;
+    Atom ABS_MT_PRESSURE;
+
+    // Pen devices are recognized by reporting pressure on their own valuator
+    struct PenDevice {
+        int deviceId;
+        ValuatorRange pressure, tiltX, tiltY;
+    };
+    std::vector<PenDevice> penDevices;
+    Atom ABS_PRESSURE;
+    Atom ABS_TILT_X;
+    Atom ABS_TILT_Y;
+
+    // Pen samples received during the current poll, reused between polls
+    std::vector<PenSample> penSamples;
+    PenSample lastPenSample = {};
+
+    // Touch frame collected during the current poll, reused between polls
+    std::vector<std::uint32_t> touchIds;
+    std::vector<TouchPhase> touchPhases;
+    std::vector<double> touchX;
+    std::vector<double> touchY;
+    std::vector<double> touchPressure;
+
+    // Last pointer position from XInput 2, to tell scrolling from movement
+    double lastPointerX, lastPointerY;
+
+    // Cursor lock state
+    // The pointer is only recentred once it leaves the inner half of the
+    // window, and without XInput 2 the deltas come from motion events, which
+    // must skip the one caused by recentring
+    bool cursorLocked;
+    Cursor invisibleCursor = None;
+    int lastLockedX, lastLockedY;
+    bool recentring;
+
+    // Software present target in the window's visual format, reallocated when
+    // the size changes
+    // Shared memory images can't be written while the server is still reading
+    // them for a put, until its completion event arrives
+    struct PresentTarget {
+        Display* display = nullptr;
+        int screen;
+        ::Window window;
+        XImage* image = nullptr;
+#ifdef ESD_WND_HAS_XSHM
+        // Shared memory images are slices of the arena shared by every window
+        // on the server, with headroom so most resizes reuse the same slice
+        std::shared_ptr<ShmArena> shmArena;
+        ShmArena::Slice shmSlice;
+        XShmSegmentInfo shmInfo; // Of the segment the image is in
+#endif
+        bool shmAvailable; // Cleared if attaching fails, e.g. for remote servers
+        bool shmImage = false;
+        bool shmPending = false;
+        int shmCompletionType = -1;
+        GC gc = nullptr;
+        PixelFormat pixelFormat;
+
+        // Set up presenting to a window through a connection, which may be
+        // another one than the window was created on
+        void init(Display* display, int screen, ::Window window);
+        void destroy();
+
+        // (Re)create the image, in shared memory if possible
+        void createImage(int width, int height);
+        void destroyImage();
+
+#ifdef ESD_WND_HAS_XSHM
+        // Point the image at a slice of the arena big enough for it, attaching
+        // its segment if needed, returning false if shared memory fails
+        bool placeShmImage();
+#endif
+
+        // Block until the server has finished reading the shared memory image
+        void waitForPresent();
+
+        // Put part of the image, already clipped to it, in the window or a
+        // pixmap of the same depth
+        // Only the last put of a present asks for a completion event
+        void putImage(Drawable drawable, const Rect& rect, bool last);
+
+        PixelBuffer getBuffer();
+    };
+    PresentTarget present;
+
+    // Window capture, grabbing into present targets for their shared memory
+    // images
+    std::unique_ptr<CaptureWriter> captureWriter;
+    PresentTarget captureTargets[CaptureWriter::bufferCount];
+    int captureWidth, captureHeight;
+    CaptureStats lastCaptureStats = {}; // Kept once capture stops
+
+    // Damage to the window since the last grab, always set without the
+    // Damage extension
+#ifdef ESD_WND_HAS_XDAMAGE
+    Damage captureDamage = None;
+#endif
+    int captureDamageType = -1;
+    bool captureDamaged;
+
+    // Grab the window into a capture target, cropped to the capture size,
+    // returning false if it can't be grabbed, e.g. while unmapped
+    bool grabCaptureFrame(PresentTarget& target, PixelBuffer& frame);
+
+    // Stop the writer, losing any error from writing, and free everything
+    // capture uses
+    void endCapture();
+
+    // Present extension frame timing, the opcode is -1 if the extension isn't
+    // available
+    int presentOpcode = -1;
+    bool presentTimingEnabled = false;
+    XID presentEventId = 0;
+    std::uint32_t presentFrame = 0; // Serial of the last frame presented
+
+    // Pixmaps frames are presented from, reused once the server reports them
+    // idle, and recreated when the window size changes
+    struct PresentPixmap {
+        Pixmap pixmap;
+        std::uint32_t serial;
+        bool idle;
+    };
+    std::vector<PresentPixmap> presentPixmaps;
+    int presentPixmapWidth = 0, presentPixmapHeight = 0;
+
+    // Completions received since the last poll, including while waiting for
+    // an idle pixmap
+    std::vector<PresentCompleteEvent> pendingPresentCompletes;
+    bool presentFlipped = false; // Whether the last shown frame was flipped
+
+    // Serials of frames presented but not completed yet, in order
+    // Every present to the window completes to every client selecting its
+    // events, so completions of other clients' presents, e.g. through Vulkan,
+    // are told apart by serial
+    std::vector<std::uint32_t> presentSerials;
+
+    // When the latest frame of any client was shown, for the frame pacer
+    std::uint64_t presentVblankUst;
+    bool presentVblankPending = false;
+    bool presentVblankSelected = false; // Whether a vblank handler is set
+
+    // Query the Present extension, leaving presentOpcode at -1 if unsupported
+    void initPresent();
+
+    // Select completion and idle events while frame timing is enabled, and
+    // completions alone while only following vblanks
+    void selectPresentEvents();
+
+    // Copy the present target into an idle pixmap and present it, waiting for
+    // one to become idle if all of them are in use
+    void presentTimed();
+
+    // Handle a Present generic event, queueing completions for the next poll
+    void handlePresentEvent(XGenericEventCookie& cookie);
+
+    void freePresentPixmaps();
+
+    // Asynchronous presenting, through a thread with its own connection so it
+    // never shares Xlib state with the thread polling the window
+    std::unique_ptr<FrameMailbox> asyncFrames;
+    std::thread asyncThread;
+    PresentTarget asyncTarget;
+    void runAsyncPresent();
+
+    // Exposed areas accumulated during the current poll
+    std::vector<Rect> damageRects;
+
+    // Polled and waited on along with the window, if attached
+    Gamepads* gamepads = nullptr;
+
+    // Key table shared with other windows on the same server, and the
+    // snapshot of it used while handling the current batch of events
+    std::shared_ptr<SharedKeyTable> sharedKeyTable;
+    std::shared_ptr<const KeyTable> keyTable;
+    int xkbEventBase;
+
+    // Translate a key press into the UTF-8 text it commits, also decoding it
+    // into codePoints
+    // The view is valid until the next key press is translated
+    std::string_view translateKeyPress(XEvent& xe);
+
+    // Look up the UTF-8 text committed by a key press through the input
+    // context, growing the lookup buffer if the commit doesn't fit
+    std::string_view lookupText(XKeyEvent& xkey);
+
+    // Query the XInput 2 extension, leaving xiOpcode at -1 if unsupported
+    void initXInput2();
+
+    // Select the XInput 2 events needed by the enabled features
+    void selectXInput2Events();
+
+    // Refresh cached information about input devices
+    void updateXInput2Devices();
+
+    // Handle an XInput 2 generic event, batching samples where possible
+    void handleXInput2Event(esd::wnd::Window& owner, XGenericEventCookie& cookie);
+
+#ifdef ESD_WND_HAS_XINPUT2
+    // Find the valuator with the given label, ignoring ones without a usable
+    // range
+    static void findValuator(const XIDeviceInfo& device, Atom label, ValuatorRange& range);
+
+    // Read a valuator from an event, mapped from its range to [0, 1]
+    static bool readValuator(const XIValuatorState& valuators, const ValuatorRange& range, double& out);
+
+    // Add a pen sample if the event comes from a pen
+    void addPenSample(const XIDeviceEvent& device);
+#endif
+
+    // Deliver batched XInput 2 samples at the end of a poll
+    void flushXInput2Events(esd::wnd::Window& owner);
+
+    // Grab the pointer for cursor lock, confining it to the window
+    // Can fail while the window isn't viewable, in which case it is retried on
+    // focus
+    void grabLockedPointer();
+
+    // Add to the damage of the current poll, skipping rectangles that are
+    // already covered and dropping ones the new rectangle covers
+    void addDamage(const Rect& rect);
+
+    // Pointer input shared by core and XInput 2 events
+    void handleButton(esd::wnd::Window& owner, unsigned int button, bool down);
+    void handleMotion(esd::wnd::Window& owner, double x, double y, double rootX, double rootY, Time time);
+    void handleLeave(esd::wnd::Window& owner);
+
+    // Turn pointer motion into relative motion while the cursor is locked
+    void handleLockedMotion(int x, int y, Time time);
+
+    // Create the input context, with pre-edit callbacks if the input method
+    // supports them
+    void createInputContext(esd::wnd::Window* owner);
+
+    // Append XIM text, in either wide or locale multibyte encoding, to a
+    // UTF-8 string
+    static void appendXimText(const XIMText& text, std::string& out);
+
+    // Pre-edit callbacks, called from XFilterEvent with the window as client
+    // data
+    static int onPreeditStart(XIC ic, XPointer clientData, XPointer callData);
+    static void onPreeditDone(XIM im, XPointer clientData, XPointer callData);
+    static void onPreeditDraw(XIM im, XPointer clientData, XPointer callData);
+    static void onPreeditCaret(XIM im, XPointer clientData, XPointer callData);
 
-    Key fromX11KeyCode(unsigned int x11KeyCode);
-    void initKeyTables();
+    // Check the locale modifiers for an input method other than the built-in
+    // one
+    static bool isRealInputMethod(const char* localeModifiers);
 };
\ No newline at end of file
@@ -21,13 +21,16 @@
 #pragma once
 
 #include <eseed/window/input.hpp>
-#include <map>
 #include <X11/Xlib.h>
 #include <X11/XKBlib.h>
+#include <cstddef>
+#include <cstdint>
 
 namespace esd::wnd {
 
-const std::map<const char*, Key> keyMappings = {
+struct KeyMapping { const char* name; Key key; };
+
+constexpr KeyMapping keyMappings[] = {
     { "AE01", Key::Num1 },
     { "AE02", Key::Num2 },
     { "AE03", Key::Num3 },
@@ -132,4 +135,71 @@ const std::map<const char*, Key> keyMappings = {
     { "KP9", Key::Numpad9 },
 };
 
+// Pack an XKB key name (up to 4 chars, not necessarily null terminated) into
+// a single integer so it can be hashed and compared in one go
+constexpr std::uint32_t packKeyName(const char* name) {
+    std::uint32_t packed = 0;
+    for (std::size_t i = 0; i < XkbKeyNameLength && name[i] != '\0'; i++)
+        packed |= static_cast<std::uint32_t>(static_cast<unsigned char>(name[i])) << (i * 8);
+    return packed;
+}
+
+// Perfect hash table from packed XKB key names to esd keys, built entirely at
+// compile time
+// A multiplier is searched for that maps every name in keyMappings to its own
+// slot, so a lookup is a single multiply, shift and compare
+class XkbKeyNameTable {
+public:
+    static constexpr std::size_t slotBits = 10;
+    static constexpr std::size_t slotCount = std::size_t(1) << slotBits;
+    static constexpr std::size_t mappingCount = sizeof(keyMappings) / sizeof(keyMappings[0]);
+    static constexpr std::uint8_t emptySlot = 0xFF;
+
+    static_assert(mappingCount < emptySlot, "Too many key mappings for 8-bit slots");
+
+    constexpr XkbKeyNameTable() {
+        // Step through odd multiples of the 64-bit golden ratio, which spread
+        // the high bits far better than consecutive odd numbers would
+        std::uint64_t candidate = 0;
+        while (true) {
+            candidate = (candidate + 0x9E3779B97F4A7C15) | 1;
+            if (tryMultiplier(candidate)) {
+                multiplier = candidate;
+                return;
+            }
+        }
+    }
+
+    Key find(const char* name) const {
+        std::uint32_t packed = packKeyName(name);
+        std::uint8_t index = slots[slotOf(packed, multiplier)];
+        if (index == emptySlot || names[index] != packed) return Key::Unknown;
+        return keyMappings[index].key;
+    }
+
+private:
+    std::uint64_t multiplier = 0;
+    std::uint8_t slots[slotCount] = {};
+    std::uint32_t names[mappingCount] = {};
+
+    static constexpr std::size_t slotOf(std::uint32_t packed, std::uint64_t multiplier) {
+        return static_cast<std::size_t>((packed * multiplier) >> (64 - slotBits));
+    }
+
+    constexpr bool tryMultiplier(std::uint64_t candidate) {
+        for (std::size_t i = 0; i < slotCount; i++) slots[i] = emptySlot;
+
+        for (std::size_t i = 0; i < mappingCount; i++) {
+            names[i] = packKeyName(keyMappings[i].name);
+            std::size_t slot = slotOf(names[i], candidate);
+            if (slots[slot] != emptySlot) return false;
+            slots[slot] = static_cast<std::uint8_t>(i);
+        }
+
+        return true;
+    }
+};
+
+constexpr XkbKeyNameTable xkbKeyNameTable;
+
 }
\ No newline at end of file
@@ -0,0 +1,304 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#include "keytable.hpp"
+#include "inputmappings.hpp"
+#include "keysymucs.hpp"
+#include <X11/XKBlib.h>
+#include <X11/Xutil.h>
+#include <X11/keysym.h>
+#include <algorithm>
+#include <map>
+#include <string>
+
+using namespace esd::wnd;
+
+namespace {
+
+// Lookups are binary searches
+constexpr bool isKeySymUcsTableSorted() {
+    for (std::size_t i = 1; i < keySymUcsCount; i++) {
+        if (keySymUcsTable[i - 1].keySym >= keySymUcsTable[i].keySym) return false;
+    }
+    return true;
+}
+static_assert(isKeySymUcsTableSorted(), "keySymUcsTable must be sorted by keysym");
+
+}
+
+char32_t KeyTable::keySymToCodePoint(KeySym keySym) {
+    
+    // Latin-1 keysyms are equal to their code points
+    if ((keySym >= 0x20 && keySym <= 0x7E) || (keySym >= 0xA0 && keySym <= 0xFF))
+        return static_cast<char32_t>(keySym);
+
+    // Directly encoded Unicode keysyms
+    if (keySym >= 0x01000100 && keySym <= 0x0110FFFF)
+        return static_cast<char32_t>(keySym - 0x01000000);
+
+    switch (keySym) {
+    case XK_BackSpace: return 0x08;
+    case XK_Tab: 
+    case XK_KP_Tab: return 0x09;
+    case XK_Linefeed: return 0x0A;
+    case XK_Return: 
+    case XK_KP_Enter: return 0x0D;
+    case XK_Escape: return 0x1B;
+    case XK_Delete: return 0x7F;
+    case XK_KP_Space: return ' ';
+    case XK_KP_Equal: return '=';
+    case XK_KP_Multiply: return '*';
+    case XK_KP_Add: return '+';
+    case XK_KP_Separator: return ',';
+    case XK_KP_Subtract: return '-';
+    case XK_KP_Decimal: return '.';
+    case XK_KP_Divide: return '/';
+    }
+
+    if (keySym >= XK_KP_0 && keySym <= XK_KP_9)
+        return static_cast<char32_t>('0' + keySym - XK_KP_0);
+
+    // Legacy character sets (Latin-2 to 4, Cyrillic, Greek, Arabic, Hebrew,
+    // Thai, the Euro sign and so on)
+    if (keySym >= 0x100 && keySym <= 0x20FF) {
+        auto entry = std::lower_bound(
+            std::begin(keySymUcsTable), std::end(keySymUcsTable), keySym,
+            [](const KeySymUcs& entry, KeySym keySym) { return entry.keySym < keySym; }
+        );
+        if (entry != std::end(keySymUcsTable) && entry->keySym == keySym) return entry->ucs;
+        return inputMethodOnly;
+    }
+
+    // Dead keys and compose
+    if ((keySym >= XK_dead_grave && keySym <= 0xFE8F) || keySym == XK_Multi_key) 
+        return inputMethodOnly;
+
+    // Function, modifier and other keys that don't type anything
+    return 0;
+}
+
+Key KeyTable::fromX11KeyCode(unsigned int x11KeyCode) const {
+    if (x11KeyCode >= esdKeys.size())
+        return Key::Unknown;
+
+    return esdKeys[x11KeyCode];
+}
+
+unsigned int KeyTable::toX11KeyCode(Key key) const {
+    if ((std::size_t)key >= x11KeyCodes.size())
+        return 0;
+
+    return x11KeyCodes[(std::size_t)key];
+}
+
+char32_t KeyTable::translateKey(unsigned int x11KeyCode, unsigned int state) const {
+    if (x11KeyCode >= keyChars.size()) return 0;
+
+    const KeyChars& key = keyChars[x11KeyCode];
+    if (key.groupCount == 0) return 0;
+
+    // Bring out of range groups back into range the same way XKB does
+    unsigned int group = XkbGroupForCoreState(state);
+    if (group >= key.groupCount) {
+        switch (XkbOutOfRangeGroupAction(key.groupInfo)) {
+        case XkbClampIntoRange:
+            group = key.groupCount - 1;
+            break;
+        case XkbRedirectIntoRange:
+            group = XkbOutOfRangeGroupNumber(key.groupInfo);
+            if (group >= key.groupCount) group = 0;
+            break;
+        default:
+            group %= key.groupCount;
+        }
+    }
+
+    // The key type maps the relevant modifiers to a shift level
+    const KeyType& type = keyTypes[key.types[group]];
+    unsigned int mods = state & type.mask;
+    unsigned int level = 0;
+    for (const auto& entry : type.entries) {
+        if (entry.mods == mods) {
+            level = entry.level;
+            break;
+        }
+    }
+    if (level >= key.width) return 0;
+
+    // Lock the key type doesn't use for a shift level upper cases the
+    // character, as in XLookupString, and so does Shift on keys with only one
+    // level, as the core protocol does for keys with a single keysym
+    bool upper = ((state & LockMask) && !(type.mask & LockMask))
+        || ((state & ShiftMask) && key.width == 1);
+
+    std::size_t index = key.offset + group * key.width + level;
+    char32_t codePoint = upper ? upperChars[index] : chars[index];
+
+    // Control characters, as produced by XLookupString
+    if ((state & ControlMask) && codePoint != inputMethodOnly) {
+        if ((codePoint >= '@' && codePoint < 0x7F) || codePoint == ' ') codePoint &= 0x1F;
+        else if (codePoint == '2') codePoint = 0x00;
+        else if (codePoint >= '3' && codePoint <= '7') codePoint -= '3' - 0x1B;
+        else if (codePoint == '8') codePoint = 0x7F;
+        else if (codePoint == '/') codePoint = 0x1F;
+    }
+
+    return codePoint;
+}
+
+std::shared_ptr<const KeyTable> KeyTable::build(Display* display) {
+
+    auto table = std::make_shared<KeyTable>();
+
+    // Get list of XKB names and their associated key codes for the current
+    // environment
+    XkbDescPtr desc = XkbGetMap(display, XkbAllClientInfoMask, XkbUseCoreKbd);
+    XkbGetNames(display, XkbKeyNamesMask, desc);
+
+    // Size key lookup tables to fit all the possible keys
+    // Key code 0 is never used by X11, so it marks unmapped esd keys
+    table->esdKeys.resize(desc->max_key_code + 1, Key::Unknown);
+    table->x11KeyCodes.resize((std::size_t)Key::LastKey + 1, 0);
+
+    for (unsigned int x11KeyCode = desc->min_key_code; x11KeyCode <= desc->max_key_code; x11KeyCode++) {
+
+        // Any key with no corresponding esd key will be set to unknown
+        Key key = xkbKeyNameTable.find(desc->names->keys[x11KeyCode].name);
+        table->esdKeys[x11KeyCode] = key;
+        
+        if (key != Key::Unknown) table->x11KeyCodes[(std::size_t)key] = x11KeyCode;
+    }
+
+    // Copy key types with only their active modifier mappings
+    table->keyTypes.resize(desc->map->num_types);
+    for (unsigned int i = 0; i < desc->map->num_types; i++) {
+        const XkbKeyTypeRec& xkbType = desc->map->types[i];
+        table->keyTypes[i].mask = xkbType.mods.mask;
+        for (unsigned int j = 0; j < xkbType.map_count; j++) {
+            if (xkbType.map[j].active)
+                table->keyTypes[i].entries.push_back({ xkbType.map[j].mods.mask, xkbType.map[j].level });
+        }
+    }
+
+    // Convert every keysym in the map to a character up front
+    table->keyChars.resize(desc->max_key_code + 1, KeyChars {});
+    for (unsigned int x11KeyCode = desc->min_key_code; x11KeyCode <= desc->max_key_code; x11KeyCode++) {
+        KeyChars& key = table->keyChars[x11KeyCode];
+        key.groupCount = XkbKeyNumGroups(desc, x11KeyCode);
+        key.groupInfo = XkbKeyGroupInfo(desc, x11KeyCode);
+        key.width = XkbKeyGroupsWidth(desc, x11KeyCode);
+        key.offset = table->chars.size();
+
+        for (unsigned int group = 0; group < key.groupCount; group++) {
+            key.types[group] = XkbKeyKeyTypeIndex(desc, x11KeyCode, group);
+            for (unsigned int level = 0; level < key.width; level++) {
+                KeySym keySym = XkbKeySymEntry(desc, x11KeyCode, level, group);
+                KeySym lower, upper;
+                XConvertCase(keySym, &lower, &upper);
+                table->chars.push_back(keySymToCodePoint(keySym));
+                table->upperChars.push_back(keySymToCodePoint(upper));
+            }
+        }
+    }
+
+    // Clean up desc and its key name list
+    XkbFreeNames(desc, XkbKeyNamesMask, True);
+    XkbFreeKeyboard(desc, XkbAllClientInfoMask, True);
+
+    return table;
+}
+
+SharedKeyTable::~SharedKeyTable() {
+    {
+        std::lock_guard<std::mutex> lock(rebuildMutex);
+        stopping = true;
+    }
+    rebuildRequested.notify_one();
+    if (rebuildThread.joinable()) rebuildThread.join();
+}
+
+std::shared_ptr<SharedKeyTable> SharedKeyTable::get(Display* display) {
+    
+    // Tables are only kept alive by the windows using them
+    static std::mutex registryMutex;
+    static std::map<std::string, std::weak_ptr<SharedKeyTable>> registry;
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+
+    auto& entry = registry[DisplayString(display)];
+    auto shared = entry.lock();
+    
+    if (!shared) {
+        shared = std::make_shared<SharedKeyTable>();
+        shared->displayName = DisplayString(display);
+        std::atomic_store(&shared->table, KeyTable::build(display));
+        entry = shared;
+    }
+
+    return shared;
+}
+
+std::shared_ptr<const KeyTable> SharedKeyTable::load() const {
+    return std::atomic_load(&table);
+}
+
+void SharedKeyTable::rebuild(Display* display, Time time) {
+    std::unique_lock<std::mutex> lock(rebuildMutex);
+
+    if (requestedAt != CurrentTime && time <= requestedAt) return;
+    requestedAt = time;
+
+    if (!rebuildThread.joinable()) {
+        Display* rebuildDisplay = XOpenDisplay(displayName.c_str());
+
+        // Without a connection of its own, the rebuild has to happen here
+        if (!rebuildDisplay) {
+            std::atomic_store(&table, KeyTable::build(display));
+            builtAt = time;
+            return;
+        }
+
+        rebuildThread = std::thread(&SharedKeyTable::runRebuilds, this, rebuildDisplay);
+    }
+
+    lock.unlock();
+    rebuildRequested.notify_one();
+}
+
+void SharedKeyTable::runRebuilds(Display* display) {
+    std::unique_lock<std::mutex> lock(rebuildMutex);
+
+    while (true) {
+        rebuildRequested.wait(lock, [this] { return stopping || requestedAt != builtAt; });
+        if (stopping) break;
+
+        // Changes notified while building are picked up by another pass
+        Time time = requestedAt;
+        lock.unlock();
+        auto built = KeyTable::build(display);
+        lock.lock();
+
+        std::atomic_store(&table, std::move(built));
+        builtAt = time;
+    }
+
+    lock.unlock();
+    XCloseDisplay(display);
+}
@@ -0,0 +1,117 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include <eseed/window/input.hpp>
+#include <X11/Xlib.h>
+#include <X11/XKBlib.h>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace esd::wnd {
+
+// Immutable lookup tables between X11 key codes and esd keys for one keymap
+struct KeyTable {
+    std::vector<Key> esdKeys; // Indexed by X11 key code
+    std::vector<unsigned int> x11KeyCodes; // Indexed by esd key
+
+    // Character tables mirroring the XKB client map, so key presses can be
+    // translated without an input method
+    struct KeyTypeEntry { unsigned int mods; unsigned int level; };
+    struct KeyType {
+        unsigned int mask;
+        std::vector<KeyTypeEntry> entries;
+    };
+    struct KeyChars {
+        std::uint8_t groupCount;
+        std::uint8_t groupInfo;
+        std::uint8_t width; // Shift levels per group
+        std::uint8_t types[XkbNumKbdGroups];
+        std::size_t offset; // Index of the first group's characters
+    };
+    std::vector<KeyType> keyTypes;
+    std::vector<KeyChars> keyChars; // Indexed by X11 key code
+    std::vector<char32_t> chars; // Per key, group and level
+    std::vector<char32_t> upperChars; // The same characters in upper case
+
+    // Marks characters that only an input method can produce, e.g. dead keys
+    // and keysyms without a direct Unicode equivalent
+    static constexpr char32_t inputMethodOnly = 0xFFFFFFFF;
+
+    Key fromX11KeyCode(unsigned int x11KeyCode) const;
+    unsigned int toX11KeyCode(Key key) const;
+
+    // Get the character produced by a key press with the given core state,
+    // applying the same case and control character rules as XLookupString
+    // Returns 0 if the key produces no character, or inputMethodOnly
+    char32_t translateKey(unsigned int x11KeyCode, unsigned int state) const;
+
+    // Convert a keysym to the code point it types, 0 if it types nothing
+    // Dead keys, compose and legacy keysyms without a Unicode equivalent are
+    // inputMethodOnly
+    static char32_t keySymToCodePoint(KeySym keySym);
+
+    // Build tables from the current XKB map of the display's keyboard
+    static std::shared_ptr<const KeyTable> build(Display* display);
+};
+
+// Key table shared between every window connected to the same X server
+// Rebuilt only when the keymap changes, and swapped in atomically so windows
+// can keep using their current snapshot while a new one is being built
+class SharedKeyTable {
+public:
+    ~SharedKeyTable();
+
+    // Get the shared table for the server the display is connected to,
+    // building it if no other window is using it yet
+    static std::shared_ptr<SharedKeyTable> get(Display* display);
+
+    std::shared_ptr<const KeyTable> load() const;
+
+    // Rebuild the table after a keymap change notification, without waiting
+    // Every window receives its own copy of the notification, so rebuilds for
+    // a server time that has already been handled are skipped
+    // Windows keep the old table until the new one is swapped in, which they
+    // pick up on their next load()
+    void rebuild(Display* display, Time time);
+
+private:
+    std::string displayName;
+    std::shared_ptr<const KeyTable> table;
+
+    // Rebuilds run on a thread started by the first keymap change, with its
+    // own connection since Xlib connections can't be shared between threads
+    std::mutex rebuildMutex;
+    std::condition_variable rebuildRequested;
+    std::thread rebuildThread;
+    Time requestedAt = CurrentTime;
+    Time builtAt = CurrentTime;
+    bool stopping = false;
+
+    void runRebuilds(Display* display);
+};
+
+}
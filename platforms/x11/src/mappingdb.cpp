@@ -0,0 +1,187 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#include "mappingdb.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace esd::wnd;
+
+namespace {
+
+constexpr std::size_t guidLength = 32;
+
+// Lowercase a GUID into key, zeroing the name CRC (hex digits 4 to 7) that
+// newer databases fill in
+// Returns false if it isn't 32 hex digits
+bool normalizeGuid(const char* guid, std::size_t length, char* key) {
+    if (length != guidLength) return false;
+    for (std::size_t i = 0; i < guidLength; i++) {
+        char c = guid[i];
+        if (c >= 'A' && c <= 'F') c = static_cast<char>(c - 'A' + 'a');
+        else if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) return false;
+        key[i] = i >= 4 && i < 8 ? '0' : c;
+    }
+    return true;
+}
+
+std::uint64_t hashGuid(const char* key) {
+    std::uint64_t hash = 0xCBF29CE484222325;
+    for (std::size_t i = 0; i < guidLength; i++) {
+        hash ^= static_cast<unsigned char>(key[i]);
+        hash *= 0x100000001B3;
+    }
+    return hash;
+}
+
+// Whether a mapping's platform field, if any, is this one
+bool isForThisPlatform(std::string_view fields) {
+    constexpr std::string_view platformField = "platform:";
+    std::size_t start = fields.find(platformField);
+    if (start == std::string_view::npos) return true;
+    std::string_view platform = fields.substr(start + platformField.size());
+    return platform.substr(0, platform.find(',')) == "Linux";
+}
+
+}
+
+GamepadMappingDb::~GamepadMappingDb() {
+    unmap();
+}
+
+void GamepadMappingDb::load(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        throw std::runtime_error("Could not open gamepad mappings " + path);
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == -1) {
+        close(fd);
+        throw std::runtime_error("Could not read gamepad mappings " + path);
+    }
+
+    unmap();
+
+    // Mapping an empty file fails, but it's a valid (empty) database
+    if (info.st_size > 0) {
+        void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Could not map gamepad mappings " + path);
+        }
+        data = static_cast<const char*>(mapped);
+        size = info.st_size;
+    }
+    close(fd);
+
+    // Entries are collected before building the table, so it can be sized
+    // for them rather than for the file, and stays small enough to fill in
+    // cache
+    // Only this platform's entries are kept, most of the file is for others
+    std::vector<Slot> entries;
+    const char* end = data + size;
+    for (const char* line = data; line < end;) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        if (!lineEnd) lineEnd = end;
+
+        // Comments and blank lines don't start with a GUID, and neither do
+        // special entries like SDL's xinput one
+        const char* comma = static_cast<const char*>(std::memchr(line, ',', lineEnd - line));
+        char key[guidLength];
+        if (
+            comma && isForThisPlatform(std::string_view(comma, lineEnd - comma)) 
+            && normalizeGuid(line, comma - line, key)
+        ) {
+            entries.push_back({ hashGuid(key), static_cast<std::uint32_t>(line - data + 1) });
+        }
+
+        line = lineEnd + 1;
+    }
+
+    // At most half full
+    std::size_t capacity = 16;
+    while (capacity < entries.size() * 2) capacity *= 2;
+    slots.assign(capacity, Slot());
+    for (const Slot& entry : entries) {
+        std::size_t i = entry.hash & (capacity - 1);
+        while (slots[i].lineStart != 0) i = (i + 1) & (capacity - 1);
+        slots[i] = entry;
+    }
+}
+
+std::string_view GamepadMappingDb::find(std::string_view guid) const {
+    char key[guidLength];
+    if (slots.empty() || !normalizeGuid(guid.data(), guid.size(), key)) return {};
+
+    std::string_view fields = findExact(key);
+    if (!fields.empty()) return fields;
+
+    // Version is hex digits 24 to 27
+    std::memset(key + 24, '0', 4);
+    return findExact(key);
+}
+
+void GamepadMappingDb::unmap() {
+    if (data) munmap(const_cast<char*>(data), size);
+    data = nullptr;
+    size = 0;
+    slots.clear();
+}
+
+std::string_view GamepadMappingDb::findExact(const char* key) const {
+    std::uint64_t hash = hashGuid(key);
+    std::string_view found;
+    std::size_t foundLine = 0;
+
+    // Every entry for the GUID is in the probe sequence before the first
+    // empty slot, and the latest line for this platform wins
+    for (std::size_t i = hash & (slots.size() - 1); slots[i].lineStart != 0; i = (i + 1) & (slots.size() - 1)) {
+        if (slots[i].hash != hash) continue;
+
+        std::size_t lineStart = slots[i].lineStart - 1;
+        if (found.data() && lineStart < foundLine) continue;
+
+        const char* line = data + lineStart;
+        const char* end = data + size;
+        const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        if (!lineEnd) lineEnd = end;
+        if (lineEnd > line && lineEnd[-1] == '\r') lineEnd--;
+
+        char lineKey[guidLength];
+        if (!normalizeGuid(line, guidLength, lineKey) || std::memcmp(lineKey, key, guidLength) != 0) continue;
+
+        // Skip the GUID and name
+        std::string_view fields(line, lineEnd - line);
+        std::size_t nameEnd = fields.find(',', guidLength + 1);
+        if (nameEnd == std::string_view::npos) continue;
+        fields.remove_prefix(nameEnd + 1);
+
+        if (!isForThisPlatform(fields)) continue;
+        found = fields;
+        foundLine = lineStart;
+    }
+
+    return found;
+}
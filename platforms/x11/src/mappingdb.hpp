@@ -0,0 +1,64 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace esd::wnd {
+
+// SDL-style gamepad mapping database (gamecontrollerdb.txt)
+// The file is memory-mapped and only indexed by GUID when loaded, the mappings
+// themselves are left for the caller to parse for pads that actually connect
+class GamepadMappingDb {
+public:
+    GamepadMappingDb() = default;
+    GamepadMappingDb(const GamepadMappingDb&) = delete;
+    ~GamepadMappingDb();
+
+    // Replace the database with the one in the file, throwing if it can't be
+    // mapped
+    void load(const std::string& path);
+
+    // Get the mapping fields (after the GUID and name) for a GUID of 32 hex
+    // digits, or an empty view if there is none for this platform
+    // The name CRC in the GUID is ignored, and entries without a version are
+    // used if no entry matches the exact version
+    // Later entries override earlier ones, like in SDL
+    std::string_view find(std::string_view guid) const;
+
+private:
+    void unmap();
+    std::string_view findExact(const char* key) const;
+
+    const char* data = nullptr;
+    std::size_t size = 0;
+
+    // Open addressing table over normalized GUIDs, with a power of two size
+    // lineStart is offset by one so zero marks an empty slot
+    struct Slot { std::uint64_t hash; std::uint32_t lineStart; };
+    std::vector<Slot> slots;
+};
+
+}
@@ -0,0 +1,345 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#include "impl.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <X11/Xutil.h>
+
+using namespace esd::wnd;
+
+namespace {
+
+PixelFormat getPixelFormat(const Visual* visual, const XImage* image) {
+    const std::uint16_t one = 1;
+    bool hostLsbFirst = *reinterpret_cast<const unsigned char*>(&one) == 1;
+    bool lsbFirst = image->byte_order == LSBFirst;
+
+    unsigned long r = visual->red_mask;
+    unsigned long g = visual->green_mask;
+    unsigned long b = visual->blue_mask;
+
+    if (image->bits_per_pixel == 32) {
+        if (r == 0xFF0000 && g == 0xFF00 && b == 0xFF) return lsbFirst ? PixelFormat::Bgrx8888 : PixelFormat::Xrgb8888;
+        if (r == 0xFF && g == 0xFF00 && b == 0xFF0000) return lsbFirst ? PixelFormat::Rgbx8888 : PixelFormat::Xbgr8888;
+        if (r == 0x3FF00000 && g == 0xFFC00 && b == 0x3FF && lsbFirst == hostLsbFirst) return PixelFormat::Xrgb2101010;
+    }
+
+    if (image->bits_per_pixel == 16 && r == 0xF800 && g == 0x7E0 && b == 0x1F && lsbFirst == hostLsbFirst) {
+        return PixelFormat::Rgb565;
+    }
+
+    return PixelFormat::Unknown;
+}
+
+}
+
+void esd::wnd::Window::Impl::PresentTarget::init(Display* display, int screen, ::Window window) {
+    this->display = display;
+    this->screen = screen;
+    this->window = window;
+    gc = XCreateGC(display, window, 0, nullptr);
+
+#ifdef ESD_WND_HAS_XSHM
+    shmAvailable = XShmQueryExtension(display);
+    if (shmAvailable) {
+        shmCompletionType = XShmGetEventBase(display) + ShmCompletion;
+        shmArena = ShmArena::get(display);
+        shmAvailable = shmArena != nullptr;
+    }
+#else
+    shmAvailable = false;
+#endif
+}
+
+void esd::wnd::Window::Impl::PresentTarget::destroy() {
+    if (!gc) return;
+
+    destroyImage();
+#ifdef ESD_WND_HAS_XSHM
+    if (shmArena) shmArena->free(shmSlice);
+    shmArena.reset();
+#endif
+    XFreeGC(display, gc);
+    gc = nullptr;
+}
+
+void esd::wnd::Window::Impl::PresentTarget::createImage(int width, int height) {
+    destroyImage();
+
+    Visual* visual = DefaultVisual(display, screen);
+    int depth = DefaultDepth(display, screen);
+
+#ifdef ESD_WND_HAS_XSHM
+    if (shmAvailable) {
+        image = XShmCreateImage(display, visual, depth, ZPixmap, nullptr, &shmInfo, width, height);
+        if (image && placeShmImage()) {
+            shmImage = true;
+            pixelFormat = getPixelFormat(visual, image);
+            return;
+        }
+
+        if (image) {
+            XDestroyImage(image);
+            image = nullptr;
+        }
+        shmArena->free(shmSlice);
+
+        // Don't retry on every resize
+        shmAvailable = false;
+    }
+#endif
+
+    // Client side image, copied over the connection on every put
+    image = XCreateImage(display, visual, depth, ZPixmap, 0, nullptr, width, height, 32, 0);
+    if (!image) {
+        throw std::runtime_error("Could not create X11 image");
+    }
+    image->data = static_cast<char*>(std::malloc(image->bytes_per_line * image->height));
+    if (!image->data) {
+        XDestroyImage(image);
+        image = nullptr;
+        throw std::runtime_error("Could not allocate X11 image");
+    }
+    pixelFormat = getPixelFormat(visual, image);
+}
+
+void esd::wnd::Window::Impl::PresentTarget::destroyImage() {
+    if (!image) return;
+
+#ifdef ESD_WND_HAS_XSHM
+    // The slice is kept for the next image
+    if (shmImage) {
+        waitForPresent();
+        image->data = nullptr;
+        shmImage = false;
+    }
+#endif
+
+    XDestroyImage(image);
+    image = nullptr;
+}
+
+#ifdef ESD_WND_HAS_XSHM
+bool esd::wnd::Window::Impl::PresentTarget::placeShmImage() {
+    std::size_t size = std::size_t(image->bytes_per_line) * image->height;
+
+    // Slices get half their size again as headroom for growing, and are
+    // replaced when shrinking to under a quarter, to give memory back
+    if (!shmSlice.segment || shmSlice.size < size || shmSlice.size / 4 > size) {
+        shmArena->free(shmSlice);
+        shmSlice = shmArena->allocate(size + size / 2);
+        if (!shmSlice.segment) return false;
+    }
+
+    // Puts find the offset of the image's data from shmInfo.shmaddr
+    shmInfo = shmSlice.segment->info;
+    image->data = shmInfo.shmaddr + shmSlice.offset;
+    return true;
+}
+#endif
+
+void esd::wnd::Window::Impl::PresentTarget::waitForPresent() {
+    if (!shmPending) return;
+
+    // Other events are left queued for the next poll
+    XEvent xe;
+    XIfEvent(display, &xe, [](Display* display, XEvent* xe, XPointer arg) -> Bool {
+        return xe->type == reinterpret_cast<PresentTarget*>(arg)->shmCompletionType;
+    }, reinterpret_cast<XPointer>(this));
+    shmPending = false;
+}
+
+void esd::wnd::Window::Impl::PresentTarget::putImage(Drawable drawable, const Rect& rect, bool last) {
+#ifdef ESD_WND_HAS_XSHM
+    if (shmImage) {
+        XShmPutImage(display, drawable, gc, image, rect.x, rect.y, rect.x, rect.y, rect.w, rect.h, last);
+        if (last) shmPending = true;
+        return;
+    }
+#endif
+
+    XPutImage(display, drawable, gc, image, rect.x, rect.y, rect.x, rect.y, rect.w, rect.h);
+}
+
+PixelBuffer esd::wnd::Window::Impl::PresentTarget::getBuffer() {
+    PixelBuffer buffer;
+    buffer.data = image->data;
+    buffer.stride = image->bytes_per_line;
+    buffer.width = image->width;
+    buffer.height = image->height;
+    buffer.format = pixelFormat;
+    return buffer;
+}
+
+PixelBuffer esd::wnd::Window::getPixelBuffer() {
+    auto& present = impl->present;
+    if (!present.gc) present.init(impl->display, impl->screen, impl->window);
+
+    // Images can't be empty, even while the window is
+    int width = std::max(impl->width, 1);
+    int height = std::max(impl->height, 1);
+    if (!present.image || present.image->width != width || present.image->height != height) {
+        present.createImage(width, height);
+    } else {
+        present.waitForPresent();
+    }
+
+    return present.getBuffer();
+}
+
+void esd::wnd::Window::presentPixelBuffer() {
+    auto& present = impl->present;
+    if (!present.image) return;
+
+    if (impl->presentTimingEnabled) {
+        impl->presentTimed();
+        return;
+    }
+
+    present.putImage(impl->window, { 0, 0, present.image->width, present.image->height }, true);
+    XFlush(impl->display);
+}
+
+void esd::wnd::Window::presentPixelBuffer(const Rect* rects, std::size_t rectCount) {
+    auto& present = impl->present;
+    if (!present.image) return;
+
+    // Frames presented with timing are always whole
+    if (impl->presentTimingEnabled) {
+        impl->presentTimed();
+        return;
+    }
+
+    // Find the last rectangle left after clipping, which is the one to ask
+    // for a completion event
+    auto clip = [&](Rect rect) {
+        int x1 = std::clamp(rect.x, 0, present.image->width);
+        int y1 = std::clamp(rect.y, 0, present.image->height);
+        int x2 = std::clamp(rect.x + rect.w, 0, present.image->width);
+        int y2 = std::clamp(rect.y + rect.h, 0, present.image->height);
+        return Rect{ x1, y1, x2 - x1, y2 - y1 };
+    };
+    std::size_t lastRect = rectCount;
+    for (std::size_t i = 0; i < rectCount; i++) {
+        Rect rect = clip(rects[i]);
+        if (rect.w > 0 && rect.h > 0) lastRect = i;
+    }
+
+    for (std::size_t i = 0; i < rectCount; i++) {
+        Rect rect = clip(rects[i]);
+        if (rect.w > 0 && rect.h > 0) present.putImage(impl->window, rect, i == lastRect);
+    }
+    XFlush(impl->display);
+}
+
+void esd::wnd::Window::startAsyncPresent(PixelFormat format) {
+    if (impl->asyncFrames) stopAsyncPresent();
+
+    // Xlib connections can't be shared between threads without locking every
+    // call, so the present thread gets its own
+    Display* display = XOpenDisplay(DisplayString(impl->display));
+    if (!display) {
+        throw std::runtime_error("Could not open X11 display for presenting");
+    }
+    impl->asyncTarget.init(display, impl->screen, impl->window);
+    impl->asyncFrames = std::make_unique<FrameMailbox>(format);
+    impl->asyncThread = std::thread([this] { impl->runAsyncPresent(); });
+}
+
+void esd::wnd::Window::stopAsyncPresent() {
+    if (!impl->asyncFrames) return;
+
+    impl->asyncFrames->stop();
+    impl->asyncThread.join();
+    impl->asyncFrames.reset();
+
+    Display* display = impl->asyncTarget.display;
+    impl->asyncTarget.destroy();
+    XCloseDisplay(display);
+    impl->asyncTarget = {};
+}
+
+PixelBuffer esd::wnd::Window::acquireFrame(int width, int height) {
+    if (!impl->asyncFrames) {
+        throw std::runtime_error("Asynchronous presenting isn't started");
+    }
+    return impl->asyncFrames->acquire(width, height);
+}
+
+void esd::wnd::Window::submitFrame() {
+    if (impl->asyncFrames) impl->asyncFrames->submit();
+}
+
+PresentStats esd::wnd::Window::getPresentStats() {
+    return impl->asyncFrames ? impl->asyncFrames->getStats() : PresentStats{};
+}
+
+void esd::wnd::Window::Impl::runAsyncPresent() {
+    try {
+        PixelBuffer frame;
+        while (asyncFrames->take(frame)) {
+            if (frame.width > 0 && frame.height > 0) {
+                auto& target = asyncTarget;
+                if (!target.image || target.image->width != frame.width || target.image->height != frame.height) {
+                    target.createImage(frame.width, frame.height);
+                }
+
+                // The previous put has always completed, so the image is free
+                convertPixels(frame, target.getBuffer());
+                target.putImage(target.window, { 0, 0, frame.width, frame.height }, true);
+
+                // Latency covers the server reading the frame, which
+                // without shared memory is only known after a round trip
+                if (target.shmImage) {
+                    XFlush(target.display);
+                    target.waitForPresent();
+                } else {
+                    XSync(target.display, False);
+                }
+            }
+            asyncFrames->release();
+        }
+    } catch (...) {
+        asyncFrames->fail(std::current_exception());
+    }
+}
+
+void esd::wnd::Window::Impl::addDamage(const Rect& rect) {
+    if (rect.w <= 0 || rect.h <= 0) return;
+
+    auto contains = [](const Rect& outer, const Rect& inner) {
+        return inner.x >= outer.x && inner.y >= outer.y
+            && inner.x + inner.w <= outer.x + outer.w 
+            && inner.y + inner.h <= outer.y + outer.h;
+    };
+
+    for (const auto& damageRect : damageRects) {
+        if (contains(damageRect, rect)) return;
+    }
+    damageRects.erase(
+        std::remove_if(damageRects.begin(), damageRects.end(), 
+            [&](const Rect& damageRect) { return contains(rect, damageRect); }),
+        damageRects.end()
+    );
+    damageRects.push_back(rect);
+}
@@ -0,0 +1,272 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#include "impl.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+// There is no client library for the extension in Xlib, so requests and events
+// are encoded from the protocol headers
+// The protocol header defines Window and Pixmap as macros, so it goes last
+#ifdef ESD_WND_HAS_PRESENT
+#include <X11/Xlibint.h>
+#include <X11/extensions/presentproto.h>
+#endif
+
+using namespace esd::wnd;
+
+#ifdef ESD_WND_HAS_PRESENT
+
+namespace {
+
+// Generic events of extensions Xlib doesn't know are dropped, so Present
+// events are queued as cookies holding a copy of the wire event
+std::size_t getWireSize(const void* event) {
+    return 32 + static_cast<const xGenericEvent*>(event)->length * 4;
+}
+
+Bool wireToPresentCookie(Display* dpy, XGenericEventCookie* cookie, xEvent* event) {
+    auto ge = reinterpret_cast<xGenericEvent*>(event);
+    cookie->type = ge->type & 0x7F;
+    cookie->serial = _XSetLastRequestRead(dpy, reinterpret_cast<xGenericReply*>(event));
+    cookie->send_event = (ge->type & 0x80) != 0;
+    cookie->display = dpy;
+    cookie->extension = ge->extension;
+    cookie->evtype = ge->evtype;
+
+    std::size_t size = getWireSize(event);
+    cookie->data = std::malloc(size);
+    if (!cookie->data) return False;
+    std::memcpy(cookie->data, event, size);
+    return True;
+}
+
+Bool copyPresentCookie(Display* dpy, XGenericEventCookie* in, XGenericEventCookie* out) {
+    std::size_t size = getWireSize(in->data);
+    *out = *in;
+    out->data = std::malloc(size);
+    if (!out->data) return False;
+    std::memcpy(out->data, in->data, size);
+    return True;
+}
+
+}
+
+void esd::wnd::Window::Impl::initPresent() {
+    int firstEvent, firstError;
+    if (!XQueryExtension(display, PRESENT_NAME, &presentOpcode, &firstEvent, &firstError)) {
+        presentOpcode = -1;
+        return;
+    }
+
+    // The server needs the version we use before anything else
+    Display* dpy = display;
+    xPresentQueryVersionReq* req;
+    xPresentQueryVersionReply reply;
+    LockDisplay(dpy);
+    GetReq(PresentQueryVersion, req);
+    req->reqType = presentOpcode;
+    req->presentReqType = X_PresentQueryVersion;
+    req->majorVersion = PRESENT_MAJOR;
+    req->minorVersion = PRESENT_MINOR;
+    Status status = _XReply(dpy, reinterpret_cast<xReply*>(&reply), 0, xTrue);
+    UnlockDisplay(dpy);
+    SyncHandle();
+    if (!status) {
+        presentOpcode = -1;
+        return;
+    }
+
+    XESetWireToEventCookie(display, presentOpcode, wireToPresentCookie);
+    XESetCopyEventCookie(display, presentOpcode, copyPresentCookie);
+}
+
+void esd::wnd::Window::Impl::selectPresentEvents() {
+    if (!presentEventId) presentEventId = XAllocID(display);
+
+    // Selecting no events frees the event ID on the server side, it is then
+    // reused for the next selection
+    Display* dpy = display;
+    xPresentSelectInputReq* req;
+    LockDisplay(dpy);
+    GetReq(PresentSelectInput, req);
+    req->reqType = presentOpcode;
+    req->presentReqType = X_PresentSelectInput;
+    req->eid = presentEventId;
+    req->window = window;
+    req->eventMask = 0;
+    if (presentTimingEnabled) req->eventMask |= PresentCompleteNotifyMask | PresentIdleNotifyMask;
+    if (presentVblankSelected) req->eventMask |= PresentCompleteNotifyMask;
+    UnlockDisplay(dpy);
+    SyncHandle();
+}
+
+void esd::wnd::Window::Impl::presentTimed() {
+    auto& image = *present.image;
+    if (image.width != presentPixmapWidth || image.height != presentPixmapHeight) {
+        freePresentPixmaps();
+        presentPixmapWidth = image.width;
+        presentPixmapHeight = image.height;
+    }
+
+    // Three pixmaps are enough for one on screen, one queued for the next
+    // vblank and one being drawn, beyond that presenting waits on the server
+    constexpr std::size_t maxPixmaps = 3;
+    auto isIdle = [](const PresentPixmap& pixmap) { return pixmap.idle; };
+    auto pixmap = std::find_if(presentPixmaps.begin(), presentPixmaps.end(), isIdle);
+    if (pixmap == presentPixmaps.end() && presentPixmaps.size() < maxPixmaps) {
+        PresentPixmap created;
+        created.pixmap = XCreatePixmap(display, window, image.width, image.height, DefaultDepth(display, screen));
+        created.idle = true;
+        presentPixmaps.push_back(created);
+        pixmap = presentPixmaps.end() - 1;
+    }
+    while (pixmap == presentPixmaps.end()) {
+        // Other events are left queued for the next poll
+        XEvent xe;
+        XIfEvent(display, &xe, [](Display* display, XEvent* xe, XPointer arg) -> Bool {
+            return xe->type == GenericEvent && xe->xcookie.extension == *reinterpret_cast<int*>(arg);
+        }, reinterpret_cast<XPointer>(&presentOpcode));
+        if (XGetEventData(display, &xe.xcookie)) {
+            handlePresentEvent(xe.xcookie);
+            XFreeEventData(display, &xe.xcookie);
+        }
+        pixmap = std::find_if(presentPixmaps.begin(), presentPixmaps.end(), isIdle);
+    }
+
+    present.putImage(pixmap->pixmap, { 0, 0, image.width, image.height }, true);
+    pixmap->idle = false;
+    pixmap->serial = ++presentFrame;
+    presentSerials.push_back(pixmap->serial);
+
+    // Presented at the next vblank, without fences or a region so the whole
+    // window is updated
+    Display* dpy = display;
+    xPresentPixmapReq* req;
+    LockDisplay(dpy);
+    GetReq(PresentPixmap, req);
+    req->reqType = presentOpcode;
+    req->presentReqType = X_PresentPixmap;
+    req->window = window;
+    req->pixmap = pixmap->pixmap;
+    req->serial = pixmap->serial;
+    req->valid = 0;
+    req->update = 0;
+    req->x_off = 0;
+    req->y_off = 0;
+    req->target_crtc = 0;
+    req->wait_fence = 0;
+    req->idle_fence = 0;
+    req->options = PresentOptionNone;
+    req->target_msc = 0;
+    req->divisor = 0;
+    req->remainder = 0;
+    UnlockDisplay(dpy);
+    SyncHandle();
+    XFlush(display);
+}
+
+void esd::wnd::Window::Impl::handlePresentEvent(XGenericEventCookie& cookie) {
+    if (cookie.evtype == PresentIdleNotify) {
+        auto idle = static_cast<const xPresentIdleNotify*>(cookie.data);
+        for (auto& pixmap : presentPixmaps) {
+            if (pixmap.pixmap == idle->pixmap && pixmap.serial == idle->serial) pixmap.idle = true;
+        }
+    } else if (cookie.evtype == PresentCompleteNotify) {
+        // Completions of NotifyMSC requests aren't frames
+        auto complete = static_cast<const xPresentCompleteNotify*>(cookie.data);
+        if (complete->kind != PresentCompleteKindPixmap) return;
+
+        PresentCompleteEvent event;
+        event.frame = complete->serial;
+        event.ust = complete->ust;
+        event.msc = complete->msc;
+        switch (complete->mode) {
+        case PresentCompleteModeFlip: event.mode = PresentMode::Flip; break;
+        case PresentCompleteModeSkip: event.mode = PresentMode::Skip; break;
+        case PresentCompleteModeSuboptimalCopy: event.mode = PresentMode::SuboptimalCopy; break;
+        default: event.mode = PresentMode::Copy; break;
+        }
+        if (event.mode != PresentMode::Skip) {
+            presentVblankUst = event.ust;
+            presentVblankPending = true;
+        }
+
+        // Only our own frames are reported, frames complete in the order they
+        // were presented
+        auto serial = std::find(presentSerials.begin(), presentSerials.end(), event.frame);
+        if (serial == presentSerials.end()) return;
+        presentSerials.erase(presentSerials.begin(), serial + 1);
+
+        if (event.mode != PresentMode::Skip) presentFlipped = event.mode == PresentMode::Flip;
+        pendingPresentCompletes.push_back(event);
+    }
+}
+
+void esd::wnd::Window::Impl::freePresentPixmaps() {
+    // The server keeps pixmaps that are still being presented until it is
+    // done with them
+    for (auto& pixmap : presentPixmaps) XFreePixmap(display, pixmap.pixmap);
+    presentPixmaps.clear();
+}
+
+#else
+
+void esd::wnd::Window::Impl::initPresent() { presentOpcode = -1; }
+void esd::wnd::Window::Impl::selectPresentEvents() {}
+void esd::wnd::Window::Impl::presentTimed() {}
+void esd::wnd::Window::Impl::handlePresentEvent(XGenericEventCookie& cookie) {}
+void esd::wnd::Window::Impl::freePresentPixmaps() {}
+
+#endif
+
+bool esd::wnd::Window::isPresentTimingSupported() {
+    return impl->presentOpcode != -1;
+}
+
+bool esd::wnd::Window::isPresentTimingEnabled() {
+    return impl->presentTimingEnabled;
+}
+
+void esd::wnd::Window::setPresentTimingEnabled(bool enabled) {
+    if (impl->presentOpcode == -1 || enabled == impl->presentTimingEnabled) return;
+
+    impl->presentTimingEnabled = enabled;
+    impl->selectPresentEvents();
+    if (!enabled) {
+        // Frames still in flight won't report completing anymore
+        impl->freePresentPixmaps();
+        impl->presentSerials.clear();
+    }
+}
+
+void esd::wnd::Window::setPresentVblankHandler(std::function<void(std::uint64_t)> handler) {
+    presentVblankHandler = handler;
+    bool selected = static_cast<bool>(handler);
+    if (impl->presentOpcode == -1 || selected == impl->presentVblankSelected) return;
+
+    impl->presentVblankSelected = selected;
+    impl->selectPresentEvents();
+}
+
+std::uint32_t esd::wnd::Window::getPresentFrameNumber() {
+    return impl->presentFrame;
+}
@@ -0,0 +1,186 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#include "shmarena.hpp"
+#include "errortrap.hpp"
+#include <algorithm>
+#include <map>
+#include <string>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+using namespace esd::wnd;
+
+namespace {
+
+// Slices are aligned for vector stores
+constexpr std::size_t sliceAlignment = 64;
+
+// Enough for a few small windows before the first growth
+constexpr std::size_t minSegmentSize = 4 << 20;
+
+}
+
+std::shared_ptr<ShmArena> ShmArena::get(Display* display) {
+
+    // Arenas are only kept alive by the windows using them
+    static std::mutex registryMutex;
+    static std::map<std::string, std::weak_ptr<ShmArena>> registry;
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+
+    auto& entry = registry[DisplayString(display)];
+    auto shared = entry.lock();
+
+    if (!shared) {
+        Display* arenaDisplay = XOpenDisplay(DisplayString(display));
+        if (!arenaDisplay) return nullptr;
+        shared = std::make_shared<ShmArena>(arenaDisplay);
+        entry = shared;
+    }
+
+    return shared;
+}
+
+ShmArena::ShmArena(Display* display) : display(display) {}
+
+ShmArena::~ShmArena() {
+    // Segments are already marked for removal, and closing the connection
+    // detaches them on the server
+    for (auto& segment : segments) shmdt(segment->info.shmaddr);
+    XCloseDisplay(display);
+}
+
+ShmArena::Slice ShmArena::allocate(std::size_t size) {
+    size = (size + sliceAlignment - 1) / sliceAlignment * sliceAlignment;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // First fit, in the order segments were created
+    auto take = [&](Segment& segment) {
+        for (auto it = segment.freeBlocks.begin(); it != segment.freeBlocks.end(); ++it) {
+            if (it->size < size) continue;
+
+            Slice slice;
+            slice.segment = &segment;
+            slice.offset = it->offset;
+            slice.size = size;
+            it->offset += size;
+            it->size -= size;
+            if (it->size == 0) segment.freeBlocks.erase(it);
+            return slice;
+        }
+        return Slice{};
+    };
+
+    for (auto& segment : segments) {
+        Slice slice = take(*segment);
+        if (slice.segment) return slice;
+    }
+
+    // Each new segment is at least twice the size of the last, so the number
+    // of segments (and attaches) grows logarithmically with the memory used
+    std::size_t segmentSize = std::max(size, minSegmentSize);
+    if (!segments.empty()) segmentSize = std::max(segmentSize, segments.back()->size * 2);
+
+    Segment* segment = addSegment(segmentSize);
+    return segment ? take(*segment) : Slice{};
+}
+
+void ShmArena::free(Slice& slice) {
+    if (!slice.segment) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    Segment& segment = *slice.segment;
+    slice.segment = nullptr;
+
+    auto& blocks = segment.freeBlocks;
+    auto next = std::lower_bound(blocks.begin(), blocks.end(), slice.offset, 
+        [](const Segment::Block& block, std::size_t offset) { return block.offset < offset; });
+    auto block = blocks.insert(next, { slice.offset, slice.size });
+
+    // Merge with the following block, then the preceding one
+    auto following = block + 1;
+    if (following != blocks.end() && block->offset + block->size == following->offset) {
+        block->size += following->size;
+        block = blocks.erase(following) - 1;
+    }
+    if (block != blocks.begin()) {
+        auto preceding = block - 1;
+        if (preceding->offset + preceding->size == block->offset) {
+            preceding->size += block->size;
+            blocks.erase(block);
+        }
+    }
+
+    // The first segment is kept for the windows that come next
+    if (blocks.size() == 1 && blocks[0].size == segment.size && &segment != segments.front().get()) {
+        removeSegment(segment);
+    }
+}
+
+// Attaching fails with an X error when the server can't access the memory,
+// e.g. over the network
+ShmArena::Segment* ShmArena::addSegment(std::size_t size) {
+    int shmid = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+    if (shmid == -1) return nullptr;
+    auto address = static_cast<char*>(shmat(shmid, nullptr, 0));
+    if (address == reinterpret_cast<char*>(-1)) {
+        shmctl(shmid, IPC_RMID, nullptr);
+        return nullptr;
+    }
+
+    auto segment = std::make_unique<Segment>();
+    segment->info.shmid = shmid;
+    segment->info.shmaddr = address;
+    segment->info.readOnly = False;
+    segment->size = size;
+    segment->freeBlocks.push_back({ 0, size });
+
+    bool attached;
+    {
+        ErrorTrap trap(display);
+        attached = XShmAttach(display, &segment->info);
+        XSync(display, False);
+        attached = attached && !trap.hasFailed();
+    }
+
+    // Once the server has attached it, the segment can be marked for removal
+    // and is freed even if the process crashes
+    shmctl(shmid, IPC_RMID, nullptr);
+    if (!attached) {
+        shmdt(address);
+        return nullptr;
+    }
+
+    segments.push_back(std::move(segment));
+    return segments.back().get();
+}
+
+void ShmArena::removeSegment(Segment& segment) {
+    // Only sent after the last slice was freed, so no put still reads it
+    XShmDetach(display, &segment.info);
+    XFlush(display);
+    shmdt(segment.info.shmaddr);
+
+    segments.erase(std::find_if(segments.begin(), segments.end(), 
+        [&](const std::unique_ptr<Segment>& other) { return other.get() == &segment; }));
+}
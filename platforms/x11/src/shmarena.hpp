@@ -0,0 +1,84 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include <X11/Xlib.h>
+#include <X11/extensions/XShm.h>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace esd::wnd {
+
+// SysV shared memory for the present images of every window on the same X
+// server, so many windows share a few segments instead of one each
+// Segments grow geometrically and are split into slices, which are reused
+// once freed, and segments other than the first are removed once empty
+// Each segment is attached once, through the arena's own connection, and
+// every window's connection puts images from it by its XID, which stays
+// valid for as long as the arena exists
+class ShmArena {
+public:
+    struct Segment {
+        XShmSegmentInfo info; // Also holds the shmid and address
+        std::size_t size;
+
+        // Free blocks by offset, merged with their neighbours when freed
+        struct Block { std::size_t offset, size; };
+        std::vector<Block> freeBlocks;
+    };
+
+    struct Slice {
+        Segment* segment = nullptr; // Null if no slice is allocated
+        std::size_t offset;
+        std::size_t size;
+    };
+
+    // Get the arena for the server the display is connected to, creating it
+    // if no other window is using one yet
+    // Returns null if the arena's connection couldn't be opened
+    static std::shared_ptr<ShmArena> get(Display* display);
+
+    explicit ShmArena(Display* display);
+    ShmArena(const ShmArena&) = delete;
+    ~ShmArena();
+
+    // Allocate a slice of at least the given size, adding a segment if none
+    // has room
+    // Returns an empty slice if no segment could be created or attached, e.g.
+    // for remote servers
+    Slice allocate(std::size_t size);
+
+    // The server must be done reading the slice, as its segment may be
+    // detached right away
+    void free(Slice& slice);
+
+private:
+    std::mutex mutex;
+    Display* display;
+    std::vector<std::unique_ptr<Segment>> segments;
+
+    Segment* addSegment(std::size_t size);
+    void removeSegment(Segment& segment);
+};
+
+}
@@ -0,0 +1,185 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#include "utf8.hpp"
+#include "simd.hpp"
+
+using namespace esd::wnd;
+
+namespace {
+
+bool isContinuation(unsigned char c) { return (c & 0xC0) == 0x80; }
+
+// ASCII kernels decode whole blocks of 16 bytes up to the first one with a
+// non-ASCII byte, returning how many bytes were decoded
+
+#if defined(ESD_WND_SIMD_SSE2)
+std::size_t decodeAsciiBlocksSse2(const unsigned char* in, std::size_t length, char32_t* out) {
+    std::size_t i = 0;
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= length; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        if (_mm_movemask_epi8(bytes) != 0) break; // Non-ASCII byte in block
+
+        // Zero-extend 8-bit to 32-bit lanes
+        __m128i lo16 = _mm_unpacklo_epi8(bytes, zero);
+        __m128i hi16 = _mm_unpackhi_epi8(bytes, zero);
+        auto dst = reinterpret_cast<__m128i*>(out + i);
+        _mm_storeu_si128(dst + 0, _mm_unpacklo_epi16(lo16, zero));
+        _mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(lo16, zero));
+        _mm_storeu_si128(dst + 2, _mm_unpacklo_epi16(hi16, zero));
+        _mm_storeu_si128(dst + 3, _mm_unpackhi_epi16(hi16, zero));
+    }
+    return i;
+}
+#endif
+
+#if defined(ESD_WND_SIMD_NEON)
+std::size_t decodeAsciiBlocksNeon(const unsigned char* in, std::size_t length, char32_t* out) {
+    std::size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        uint8x16_t bytes = vld1q_u8(in + i);
+        if (vmaxvq_u8(bytes) >= 0x80) break; // Non-ASCII byte in block
+
+        // Zero-extend 8-bit to 32-bit lanes
+        uint16x8_t lo16 = vmovl_u8(vget_low_u8(bytes));
+        uint16x8_t hi16 = vmovl_u8(vget_high_u8(bytes));
+        auto dst = reinterpret_cast<uint32_t*>(out + i);
+        vst1q_u32(dst + 0, vmovl_u16(vget_low_u16(lo16)));
+        vst1q_u32(dst + 4, vmovl_u16(vget_high_u16(lo16)));
+        vst1q_u32(dst + 8, vmovl_u16(vget_low_u16(hi16)));
+        vst1q_u32(dst + 12, vmovl_u16(vget_high_u16(hi16)));
+    }
+    return i;
+}
+#endif
+
+// There is no AVX2 kernel, ASCII runs in text are rarely long enough for
+// wider blocks to pay off, so AVX2 machines use the SSE2 one
+std::size_t decodeAsciiBlocks(Isa isa, const unsigned char* in, std::size_t length, char32_t* out) {
+#if defined(ESD_WND_SIMD_SSE2)
+    if (isa == Isa::Sse2 || isa == Isa::Avx2) return decodeAsciiBlocksSse2(in, length, out);
+#endif
+#if defined(ESD_WND_SIMD_NEON)
+    if (isa == Isa::Neon) return decodeAsciiBlocksNeon(in, length, out);
+#endif
+    return 0;
+}
+
+}
+
+std::size_t esd::wnd::decodeUtf8(std::string_view text, std::vector<char32_t>& out) {
+    
+    // There can never be more code points than bytes
+    std::size_t start = out.size();
+    out.resize(start + text.size());
+
+    auto in = reinterpret_cast<const unsigned char*>(text.data());
+    std::size_t length = text.size();
+    char32_t* dst = out.data() + start;
+
+    std::size_t i = 0;
+    std::size_t n = 0;
+    Isa isa = getIsa();
+    
+    while (i < length) {
+        unsigned char c = in[i];
+
+        if (c < 0x80) {
+            std::size_t ascii = decodeAsciiBlocks(isa, in + i, length - i, dst + n);
+            if (ascii == 0) {
+                dst[n] = c;
+                ascii = 1;
+            }
+            i += ascii;
+            n += ascii;
+            continue;
+        }
+
+        // Lead byte determines the sequence length and the valid range of the
+        // second byte, which rules out overlong forms, surrogates and code
+        // points above U+10FFFF (Unicode table 3-7)
+        std::size_t size;
+        unsigned char min = 0x80, max = 0xBF;
+        char32_t codePoint;
+
+        if (c >= 0xC2 && c <= 0xDF) {
+            size = 2;
+            codePoint = c & 0x1F;
+        } else if (c >= 0xE0 && c <= 0xEF) {
+            size = 3;
+            codePoint = c & 0x0F;
+            if (c == 0xE0) min = 0xA0;
+            if (c == 0xED) max = 0x9F;
+        } else if (c >= 0xF0 && c <= 0xF4) {
+            size = 4;
+            codePoint = c & 0x07;
+            if (c == 0xF0) min = 0x90;
+            if (c == 0xF4) max = 0x8F;
+        } else {
+            break;
+        }
+
+        if (length - i < size || in[i + 1] < min || in[i + 1] > max) break;
+        
+        bool valid = true;
+        for (std::size_t j = 1; j < size; j++) {
+            if (!isContinuation(in[i + j])) {
+                valid = false;
+                break;
+            }
+            codePoint = codePoint << 6 | (in[i + j] & 0x3F);
+        }
+        if (!valid) break;
+
+        dst[n++] = codePoint;
+        i += size;
+    }
+
+    out.resize(start + n);
+    return i;
+}
+
+std::size_t esd::wnd::encodeUtf8(char32_t codePoint, char* out) {
+    if (codePoint <= 0x7F) {
+        out[0] = static_cast<char>(codePoint);
+        return 1;
+    }
+    if (codePoint <= 0x7FF) {
+        out[0] = static_cast<char>(0xC0 | codePoint >> 6);
+        out[1] = static_cast<char>(0x80 | (codePoint & 0x3F));
+        return 2;
+    }
+    if (codePoint >= 0xD800 && codePoint <= 0xDFFF) return 0;
+    if (codePoint <= 0xFFFF) {
+        out[0] = static_cast<char>(0xE0 | codePoint >> 12);
+        out[1] = static_cast<char>(0x80 | (codePoint >> 6 & 0x3F));
+        out[2] = static_cast<char>(0x80 | (codePoint & 0x3F));
+        return 3;
+    }
+    if (codePoint <= 0x10FFFF) {
+        out[0] = static_cast<char>(0xF0 | codePoint >> 18);
+        out[1] = static_cast<char>(0x80 | (codePoint >> 12 & 0x3F));
+        out[2] = static_cast<char>(0x80 | (codePoint >> 6 & 0x3F));
+        out[3] = static_cast<char>(0x80 | (codePoint & 0x3F));
+        return 4;
+    }
+    return 0;
+}
\ No newline at end of file
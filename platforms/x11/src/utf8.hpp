@@ -0,0 +1,40 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace esd::wnd {
+
+// Decode UTF-8 text, appending its code points to out
+// Decoding stops at the first invalid sequence (overlong forms, surrogates,
+// code points past U+10FFFF or truncated sequences)
+// Returns the number of bytes that were valid and decoded
+// Runs of ASCII are decoded 16 bytes at a time where getIsa() has SSE2 or NEON
+std::size_t decodeUtf8(std::string_view text, std::vector<char32_t>& out);
+
+// Encode a code point as UTF-8 into out, which must have room for 4 bytes
+// Returns the number of bytes written, or 0 if the code point is invalid
+std::size_t encodeUtf8(char32_t codePoint, char* out);
+
+}
@@ -19,15 +19,32 @@
 // SOFTWARE.
 
 #include "impl.hpp"
+#include "evdev.hpp"
 #include "inputmappings.hpp"
+#include "utf8.hpp"
 #include <eseed/window/window.hpp>
 #include <X11/Xlib.h>
 #include <X11/Xatom.h>
+#include <X11/XKBlib.h>
+#include <algorithm>
+#include <cerrno>
 #include <cstring>
+#include <cwchar>
+#include <poll.h>
+#include <stdexcept>
+
+#ifdef ESD_WND_HAS_XRANDR
+#include <X11/extensions/Xrandr.h>
+#endif
 
 using namespace esd::wnd;
 
-esd::wnd::Window::Window(std::string title, WindowSize size, std::optional<WindowPos> pos) {
+esd::wnd::Window::Window(
+    std::string title, 
+    WindowSize size, 
+    std::optional<WindowPos> pos, 
+    FullscreenMode fullscreenMode
+) {
     impl = std::make_unique<Impl>();
     impl->display = XOpenDisplay(nullptr);
 
@@ -36,40 +53,69 @@ esd::wnd::Window::Window(std::string title, WindowSize size, std::optional<Windo
     }
 
     impl->screen = DefaultScreen(impl->display);
+    impl->width = size.w;
+    impl->height = size.h;
     impl->root = RootWindow(impl->display, impl->screen);
+    impl->fullscreenMode = fullscreenMode;
+
+    // Collect atoms
+
+    impl->WM_DELETE_WINDOW = XInternAtom(impl->display, "WM_DELETE_WINDOW", False);
+    impl->_NET_WM_NAME = XInternAtom(impl->display, "_NET_WM_NAME", False);
+    impl->_NET_WM_STATE_FULLSCREEN = XInternAtom(impl->display, "_NET_WM_STATE_FULLSCREEN", False);
+    impl->_NET_FRAME_EXTENTS = XInternAtom(impl->display, "_NET_FRAME_EXTENTS", False);
+    impl->_NET_WM_STATE = XInternAtom(impl->display, "_NET_WM_STATE", False);
+    impl->UTF8_STRING = XInternAtom(impl->display, "UTF8_STRING", False);
+    impl->_NET_WM_STATE_HIDDEN = XInternAtom(impl->display, "_NET_WM_STATE_HIDDEN", False);
+    impl->_NET_WM_BYPASS_COMPOSITOR = XInternAtom(impl->display, "_NET_WM_BYPASS_COMPOSITOR", False);
+
+    // Compositing managers own a selection named after the screen
+    std::string cmSelection = "_NET_WM_CM_S" + std::to_string(impl->screen);
+    impl->_NET_WM_CM_Sn = XInternAtom(impl->display, cmSelection.c_str(), False);
+
+    Rect rect = { pos ? pos->x : 0, pos ? pos->y : 0, size.w, size.h };
+    if (fullscreenMode != FullscreenMode::Windowed) {
+        rect = impl->getMonitorRect(rect.x, rect.y);
+        impl->width = rect.w;
+        impl->height = rect.h;
+    }
     
     impl->window = XCreateSimpleWindow(
         impl->display, 
         impl->root, 
-        pos ? pos->x : 0,
-        pos ? pos->y : 0,
-        size.w, 
-        size.h, 
+        rect.x,
+        rect.y,
+        rect.w, 
+        rect.h, 
         1, 
         BlackPixel(impl->display, impl->screen), 
         WhitePixel(impl->display, impl->screen)
     );
 
-    impl->initKeyTables();
+    impl->sharedKeyTable = SharedKeyTable::get(impl->display);
+    impl->keyTable = impl->sharedKeyTable->load();
+
+    // Listen for keyboard changes so the key table can be rebuilt
+    int xkbOpcode, xkbErrorBase, xkbMajor = XkbMajorVersion, xkbMinor = XkbMinorVersion;
+    if (XkbQueryExtension(impl->display, &xkbOpcode, &impl->xkbEventBase, &xkbErrorBase, &xkbMajor, &xkbMinor)) {
+        constexpr unsigned long keymapChangeMask = XkbNewKeyboardNotifyMask | XkbMapNotifyMask | XkbNamesNotifyMask;
+        XkbSelectEvents(impl->display, XkbUseCoreKbd, keymapChangeMask, keymapChangeMask);
+    } else {
+        impl->xkbEventBase = -1;
+    }
 
     XSetLocaleModifiers("");
     impl->im = XOpenIM(impl->display, nullptr, nullptr, nullptr);
+    impl->hasInputMethod = impl->im && Impl::isRealInputMethod(XSetLocaleModifiers(nullptr));
 
     if (!impl->im) {
         XSetLocaleModifiers("@im=none");
         impl->im = XOpenIM(impl->display, nullptr, nullptr, nullptr);    
     }
 
-    impl->ic = XCreateIC(
-        impl->im,
-        XNInputStyle,
-        XIMPreeditNothing | XIMStatusNothing,
-        XNClientWindow,
-        impl->window,
-        XNFocusWindow,
-        impl->window,
-        nullptr
-    );
+    impl->createInputContext(this);
+    impl->initXInput2();
+    impl->initPresent();
     
     XSelectInput(
         impl->display, 
@@ -77,23 +123,28 @@ esd::wnd::Window::Window(std::string title, WindowSize size, std::optional<Windo
         ExposureMask 
             | KeyPressMask
             | KeyReleaseMask
+            | FocusChangeMask
             | StructureNotifyMask
+            | VisibilityChangeMask
+            | PropertyChangeMask
             | PointerMotionMask
             | LeaveWindowMask
             | ButtonPressMask
             | ButtonReleaseMask
             | ButtonMotionMask
     );
-    XMapWindow(impl->display, impl->window);
 
-    // Collect atoms
+    // Window managers read the initial state when the window is mapped, so
+    // it is mapped straight into fullscreen instead of being resized after
+    if (fullscreenMode != FullscreenMode::Windowed) {
+        XChangeProperty(
+            impl->display, impl->window, impl->_NET_WM_STATE, XA_ATOM, 32, PropModeReplace,
+            reinterpret_cast<unsigned char*>(&impl->_NET_WM_STATE_FULLSCREEN), 1
+        );
+    }
+    impl->setBypassCompositor(fullscreenMode == FullscreenMode::LowLatency);
 
-    impl->WM_DELETE_WINDOW = XInternAtom(impl->display, "WM_DELETE_WINDOW", False);
-    impl->_NET_WM_NAME = XInternAtom(impl->display, "_NET_WM_NAME", False);
-    impl->_NET_WM_STATE_FULLSCREEN = XInternAtom(impl->display, "_NET_WM_STATE_FULLSCREEN", False);
-    impl->_NET_FRAME_EXTENTS = XInternAtom(impl->display, "_NET_FRAME_EXTENTS", False);
-    impl->_NET_WM_STATE = XInternAtom(impl->display, "_NET_WM_STATE", False);
-    impl->UTF8_STRING = XInternAtom(impl->display, "UTF8_STRING", False);
+    XMapWindow(impl->display, impl->window);
 
     // Set protocols to intercept
 
@@ -111,6 +162,10 @@ esd::wnd::Window::~Window() {
 }
 
 void esd::wnd::Window::close() {
+    stopAsyncPresent();
+    impl->endCapture();
+    impl->present.destroy();
+    if (impl->invisibleCursor != None) XFreeCursor(impl->display, impl->invisibleCursor);
     XFree(impl->ic);
     XFree(impl->im);
     XDestroyWindow(impl->display, impl->window);
@@ -119,44 +174,82 @@ void esd::wnd::Window::close() {
 }
 
 void esd::wnd::Window::poll() {
+    // Pick up key tables rebuilt by other windows since the last poll
+    impl->keyTable = impl->sharedKeyTable->load();
+
     // Get events as long as there is at least one available
     while (XPending(impl->display)) {
         XEvent xe;
         XNextEvent(impl->display, &xe);
 
+        if (xe.type == impl->present.shmCompletionType) {
+            impl->present.shmPending = false;
+            continue;
+        }
+
+        if (xe.type == impl->captureDamageType) {
+            impl->captureDamaged = true;
+            continue;
+        }
+
+        if (xe.type == impl->xkbEventBase) {
+            auto& xkbe = reinterpret_cast<XkbEvent&>(xe);
+            if (
+                xkbe.any.xkb_type == XkbNewKeyboardNotify
+                    || xkbe.any.xkb_type == XkbMapNotify
+                    || xkbe.any.xkb_type == XkbNamesNotify
+            ) {
+                impl->sharedKeyTable->rebuild(impl->display, xkbe.any.time);
+                impl->keyTable = impl->sharedKeyTable->load();
+            }
+            continue;
+        }
+
+        // Input methods talk to the window through their own events
+        if (
+            impl->hasInputMethod 
+                && xe.type != KeyPress 
+                && xe.type != KeyRelease 
+                && XFilterEvent(&xe, None)
+        ) continue;
+
         switch (xe.type) {
+        case GenericEvent:
+            if (xe.xcookie.extension == impl->xiOpcode && XGetEventData(impl->display, &xe.xcookie)) {
+                impl->handleXInput2Event(*this, xe.xcookie);
+                XFreeEventData(impl->display, &xe.xcookie);
+            } else if (xe.xcookie.extension == impl->presentOpcode && XGetEventData(impl->display, &xe.xcookie)) {
+                impl->handlePresentEvent(xe.xcookie);
+                XFreeEventData(impl->display, &xe.xcookie);
+            }
+            break;
+        case FocusIn:
+            impl->focused = true;
+            XSetICFocus(impl->ic);
+            if (impl->cursorLocked) impl->grabLockedPointer();
+            break;
+        case FocusOut:
+            impl->focused = false;
+            XUnsetICFocus(impl->ic);
+            if (impl->cursorLocked) XUngrabPointer(impl->display, CurrentTime);
+            break;
+        case MappingNotify:
+            // Keep Xlib's own keysym cache used by character lookup in sync
+            XRefreshKeyboardMapping(&xe.xmapping);
+            break;
         case KeyPress:
-            if (keyCharHandler) {
-                if (!XFilterEvent(&xe, None)) {
-                    Status status;
-                    KeySym keySym;
-                    char utf8[4];
-                    Xutf8LookupString(impl->ic, &xe.xkey, utf8, 4, &keySym, &status);
-
-                    KeyCharEvent event = {};
-
-                    // Convert UTF-8 to code point
-                    if ((utf8[0] & 0x80) == 0x00) {
-                        event.codePoint = utf8[0];
-                    } else if ((utf8[0] & 0xE0) == 0xC0) {
-                        event.codePoint 
-                            = (utf8[0] & 0x1F) << 6
-                            | (utf8[1] & 0x3F);
-                    } else if ((utf8[2] & 0xF0) == 0xE0) {
-                        event.codePoint 
-                            = (utf8[0] & 0x0F) << 12
-                            | (utf8[1] & 0x3F) << 6
-                            | (utf8[2] & 0x3F);
-                    } else if ((utf8[0] & 0xF8) == 0xF0) {
-                        event.codePoint 
-                            = (utf8[0] & 0x07) << 18
-                            | (utf8[1] & 0x3F) << 12
-                            | (utf8[2] & 0x3F) << 6
-                            | (utf8[3] & 0x3F);
-                    }
+            if (keyCharHandler || textInputHandler || preeditHandler) {
+                std::string_view text = impl->translateKeyPress(xe);
 
-                    if (event.codePoint != 0)
+                if (textInputHandler) impl->pendingText += text;
+
+                if (keyCharHandler) {
+                    for (char32_t codePoint : impl->codePoints) {
+                        if (codePoint == 0) continue;
+                        KeyCharEvent event;
+                        event.codePoint = codePoint;
                         keyCharHandler(event);
+                    }
                 }
             }
             // no break
@@ -164,69 +257,27 @@ void esd::wnd::Window::poll() {
             if (keyHandler) {
                 KeyEvent event;
                 event.down = xe.type == KeyPress;
-                event.key = impl->fromX11KeyCode(xe.xkey.keycode);
+                event.key = impl->keyTable->fromX11KeyCode(xe.xkey.keycode);
                 keyHandler(event);
             }
             break;
         case ButtonPress:
-            // Scroll wheel event (press only)
-            if (xe.xbutton.button == Button4 || xe.xbutton.button == Button5) {
-                constexpr double delta = 1.0;
-                if (scrollHandler) {
-                    ScrollEvent event = {};
-                    if (xe.xbutton.button == Button4) event.vScroll = delta;
-                    else event.vScroll = -delta;
-                    scrollHandler(event);
-                }
-                break;
-            }
-            // no break
         case ButtonRelease:
-            if (mouseButtonHandler) {
-                MouseButtonEvent event;
-                event.down = xe.type == ButtonPress;
-                switch (xe.xbutton.button) {
-                case Button1:
-                    event.button = MouseButton::LButton;
-                    break;
-                case Button2:
-                    event.button = MouseButton::MButton;
-                    break;
-                case Button3:
-                    event.button = MouseButton::RButton;
-                    break;
-                default:
-                    event.button = MouseButton::Unknown;
-                }
-
-                if (event.button != MouseButton::Unknown)
-                    mouseButtonHandler(event);
-            }
+            impl->handleButton(*this, xe.xbutton.button, xe.type == ButtonPress);
             break;
         case MotionNotify:
-            if (cursorMoveHandler) {
-                CursorMoveEvent event;
-                event.pos = { 
-                    static_cast<double>(xe.xmotion.x), 
-                    static_cast<double>(xe.xmotion.y) 
-                };
-                event.screenPos = { 
-                    static_cast<double>(xe.xmotion.x_root), 
-                    static_cast<double>(xe.xmotion.y_root) 
-                };
-
-                // The cursor has entered the window if it was previously out
-                event.entered = !impl->cursorInWindow;
-                
-                cursorMoveHandler(event);
-            }
-            impl->cursorInWindow = true;
+            impl->handleMotion(
+                *this,
+                static_cast<double>(xe.xmotion.x),
+                static_cast<double>(xe.xmotion.y),
+                static_cast<double>(xe.xmotion.x_root),
+                static_cast<double>(xe.xmotion.y_root),
+                xe.xmotion.time
+            );
             break;
         case LeaveNotify:
-            if (cursorExitHandler) {
-                impl->cursorInWindow = false;
-                cursorExitHandler({});
-            }
+            impl->handleLeave(*this);
+            break;
         case ClientMessage:
             {
                 if (static_cast<Atom>(xe.xclient.data.l[0]) == impl->WM_DELETE_WINDOW) {
@@ -234,6 +285,9 @@ void esd::wnd::Window::poll() {
                 }
             }
             break;
+        case Expose:
+            impl->addDamage({ xe.xexpose.x, xe.xexpose.y, xe.xexpose.width, xe.xexpose.height });
+            break;
         case ConfigureNotify:
             // Position changed
             if (
@@ -260,16 +314,130 @@ void esd::wnd::Window::poll() {
             }
 
             impl->lastConfigure = xe.xconfigure;
+            impl->width = xe.xconfigure.width;
+            impl->height = xe.xconfigure.height;
+            break;
+        case MapNotify:
+            impl->mapped = true;
+            break;
+        case UnmapNotify:
+            impl->mapped = false;
             break;
+        case VisibilityNotify:
+            impl->visibilityState = xe.xvisibility.state;
+            break;
+        case PropertyNotify:
+            if (xe.xproperty.atom == impl->_NET_WM_STATE) {
+                impl->wmHidden = impl->hasWmState(impl->_NET_WM_STATE_HIDDEN);
+            }
+            break;
+        }
+    }
+
+    impl->flushXInput2Events(*this);
+
+    // Scrolling is accumulated into one event per poll
+    if (impl->pendingVScroll != 0.0 || impl->pendingHScroll != 0.0) {
+        if (scrollHandler) {
+            ScrollEvent event;
+            event.vScroll = impl->pendingVScroll;
+            event.hScroll = impl->pendingHScroll;
+            scrollHandler(event);
+        }
+        impl->pendingVScroll = 0.0;
+        impl->pendingHScroll = 0.0;
+    }
+
+    // Exposures are accumulated into one damage event per poll
+    if (!impl->damageRects.empty()) {
+        if (damageHandler) {
+            int x1 = impl->damageRects[0].x;
+            int y1 = impl->damageRects[0].y;
+            int x2 = x1 + impl->damageRects[0].w;
+            int y2 = y1 + impl->damageRects[0].h;
+            for (const auto& rect : impl->damageRects) {
+                x1 = std::min(x1, rect.x);
+                y1 = std::min(y1, rect.y);
+                x2 = std::max(x2, rect.x + rect.w);
+                y2 = std::max(y2, rect.y + rect.h);
+            }
+
+            DamageEvent event;
+            event.rects = impl->damageRects.data();
+            event.rectCount = impl->damageRects.size();
+            event.bounds = { x1, y1, x2 - x1, y2 - y1 };
+            damageHandler(event);
+        }
+        impl->damageRects.clear();
+    }
+
+    if (impl->presentVblankPending) {
+        impl->presentVblankPending = false;
+        if (presentVblankHandler) presentVblankHandler(impl->presentVblankUst);
+    }
+
+    // Frames that reached the screen since the last poll, in order, leaving
+    // ones presented from the handler for the next poll
+    if (!impl->pendingPresentCompletes.empty()) {
+        std::size_t count = impl->pendingPresentCompletes.size();
+        if (presentCompleteHandler) {
+            for (std::size_t i = 0; i < count; i++) {
+                PresentCompleteEvent event = impl->pendingPresentCompletes[i];
+                presentCompleteHandler(event);
+            }
+        }
+        impl->pendingPresentCompletes.erase(
+            impl->pendingPresentCompletes.begin(), 
+            impl->pendingPresentCompletes.begin() + count
+        );
+    }
+
+    // All text committed during this poll is delivered as one event
+    if (!impl->pendingText.empty()) {
+        if (textInputHandler) {
+            TextInputEvent event;
+            event.text = impl->pendingText;
+            textInputHandler(event);
+        }
+        impl->pendingText.clear();
+    }
+
+    // Only the state at the end of the poll is delivered, so unmapping and
+    // mapping again while reparenting doesn't show up
+    Visibility visibility = Visibility::Visible;
+    if (!impl->mapped || impl->wmHidden) visibility = Visibility::Minimized;
+    else if (impl->visibilityState == VisibilityPartiallyObscured) visibility = Visibility::PartiallyObscured;
+    else if (impl->visibilityState == VisibilityFullyObscured) visibility = Visibility::FullyObscured;
+    if (visibility != impl->visibility) {
+        impl->visibility = visibility;
+        if (visibilityHandler) {
+            VisibilityEvent event;
+            event.visibility = visibility;
+            visibilityHandler(event);
         }
     }
+
+    if (impl->gamepads) impl->gamepads->poll();
 }
 
 void esd::wnd::Window::waitEvents() {
 
-    // Wait for an event to become available
-    XEvent xe;
-    XPeekEvent(impl->display, &xe);
+    if (impl->gamepads) {
+        // Wait on the X connection and the gamepads' epoll set together,
+        // unless Xlib already has events queued
+        if (!XPending(impl->display)) {
+            pollfd fds[2] = {};
+            fds[0].fd = ConnectionNumber(impl->display);
+            fds[0].events = POLLIN;
+            fds[1].fd = impl->gamepads->impl->epollFd;
+            fds[1].events = POLLIN;
+            while (::poll(fds, 2, -1) == -1 && errno == EINTR);
+        }
+    } else {
+        // Wait for an event to become available
+        XEvent xe;
+        XPeekEvent(impl->display, &xe);
+    }
 
     // Then handle all the queued events like normal
     poll();
@@ -384,6 +552,45 @@ void esd::wnd::Window::setPos(WindowPos pos) {
     XFree(prop);
 }
 
+double esd::wnd::Window::getRefreshRate() {
+#ifdef ESD_WND_HAS_XRANDR
+    // The monitor is the CRTC the centre of the window is on
+    int x, y;
+    ::Window child;
+    XTranslateCoordinates(impl->display, impl->window, impl->root, impl->width / 2, impl->height / 2, &x, &y, &child);
+
+    XRRScreenResources* resources = XRRGetScreenResourcesCurrent(impl->display, impl->root);
+    if (!resources) return 0;
+
+    double refreshRate = 0;
+    for (int i = 0; i < resources->ncrtc && refreshRate == 0; i++) {
+        XRRCrtcInfo* crtc = XRRGetCrtcInfo(impl->display, resources, resources->crtcs[i]);
+        if (!crtc) continue;
+
+        bool contains = crtc->mode != None
+            && x >= crtc->x && x < crtc->x + static_cast<int>(crtc->width)
+            && y >= crtc->y && y < crtc->y + static_cast<int>(crtc->height);
+        for (int j = 0; contains && j < resources->nmode; j++) {
+            const XRRModeInfo& mode = resources->modes[j];
+            if (mode.id != crtc->mode || mode.hTotal == 0 || mode.vTotal == 0) continue;
+
+            // Modes are described by their timings, scanning lines twice or
+            // only every other line per refresh changes the line count
+            double lines = mode.vTotal;
+            if (mode.modeFlags & RR_DoubleScan) lines *= 2;
+            if (mode.modeFlags & RR_Interlace) lines /= 2;
+            refreshRate = mode.dotClock / (mode.hTotal * lines);
+        }
+        XRRFreeCrtcInfo(crtc);
+    }
+
+    XRRFreeScreenResources(resources);
+    return refreshRate;
+#else
+    return 0;
+#endif
+}
+
 bool esd::wnd::Window::isCloseRequested() {
     return impl->closeRequested;
 }
@@ -392,55 +599,54 @@ void esd::wnd::Window::setCloseRequested(bool closeRequested) {
     impl->closeRequested = closeRequested;
 }
 
-// Iterate through all the atoms contained in the _NET_WM_STATE window property
-// and check if _NET_WM_STATE_FULLSCREEN is present, to find out whether
-// fullscreen mode is active
-bool esd::wnd::Window::isFullscreen() {
+esd::wnd::Visibility esd::wnd::Window::getVisibility() {
+    return impl->visibility;
+}
+
+bool esd::wnd::Window::isVisible() {
+    return impl->visibility == Visibility::Visible || impl->visibility == Visibility::PartiallyObscured;
+}
 
+bool esd::wnd::Window::Impl::hasWmState(Atom state) {
     Atom actualType;
     int actualFormat;
-    unsigned long nitems;
+    unsigned long count;
     unsigned long bytesAfter;
-    Atom* prop;
+    unsigned char* data = nullptr;
 
-    int propertyIndex = 0;
-    
-    // Iterate over each atom for _NET_WM_STATE
-    while (bytesAfter > 0) {
-        XGetWindowProperty(
-            impl->display,
-            impl->window,
-            impl->_NET_WM_STATE,
-            propertyIndex * sizeof(Atom),
-            sizeof(Atom),
-            False,
-            AnyPropertyType,
-            &actualType,
-            &actualFormat,
-            &nitems,
-            &bytesAfter,
-            (unsigned char**)&prop
-        );
+    // The length is in 32-bit units, far more than any WM sets
+    int result = XGetWindowProperty(
+        display, window, _NET_WM_STATE, 0, 1024, False, XA_ATOM,
+        &actualType, &actualFormat, &count, &bytesAfter, &data
+    );
+    if (result != Success || !data) return false;
 
-        if (*prop == impl->_NET_WM_STATE_FULLSCREEN) {
-            // If _NET_WM_STATE_FULLSCREEN is found, fullscreen mode is active
-            // Make sure prop is freed before returning
-            XFree(prop);
-            return true;
-        }
+    // Format 32 properties are returned as longs
+    auto atoms = reinterpret_cast<Atom*>(data);
+    bool found = actualType == XA_ATOM && std::find(atoms, atoms + count, state) != atoms + count;
+    XFree(data);
+    return found;
+}
 
-        XFree(prop);
+bool esd::wnd::Window::isFullscreen() {
+    return impl->hasWmState(impl->_NET_WM_STATE_FULLSCREEN);
+}
 
-        // Check next property in the next iteration
-        propertyIndex++;
-    }
+void esd::wnd::Window::setFullscreen(bool fullscreen) {
+    setFullscreenMode(fullscreen ? FullscreenMode::Fullscreen : FullscreenMode::Windowed);
+}
 
-    // If _NET_WM_STATE_FULLSCREEN wasn't present, return false
-    return false;
+esd::wnd::FullscreenMode esd::wnd::Window::getFullscreenMode() {
+    return impl->fullscreenMode;
 }
 
-// Send a ClientMessage event to X requesting fullscreen
-void esd::wnd::Window::setFullscreen(bool fullscreen) {
+void esd::wnd::Window::setFullscreenMode(FullscreenMode mode) {
+    bool fullscreen = mode != FullscreenMode::Windowed;
+    impl->fullscreenMode = mode;
+
+    // Set first, so the compositor sees it by the time the window is
+    // fullscreen
+    impl->setBypassCompositor(mode == FullscreenMode::LowLatency);
 
     XEvent xe = {};
     xe.xclient.type = ClientMessage;
@@ -461,18 +667,26 @@ void esd::wnd::Window::setFullscreen(bool fullscreen) {
         SubstructureNotifyMask,
         &xe
     );
+    XFlush(impl->display);
+}
+
+esd::wnd::FullscreenStatus esd::wnd::Window::getFullscreenStatus() {
+    FullscreenStatus status;
+    status.fullscreen = isFullscreen();
+    status.composited = XGetSelectionOwner(impl->display, impl->_NET_WM_CM_Sn) != None;
+    status.flipped = impl->presentFlipped;
+    return status;
 }
 
 bool esd::wnd::Window::isKeyDown(Key key) {
+    unsigned int x11KeyCode = impl->keyTable->toX11KeyCode(key);
+    if (x11KeyCode == 0) return false;
+
+    // Bit array with one bit for each key code
     char keys[32];
     XQueryKeymap(impl->display, keys);
 
-    for (size_t i = 0; i < 32; i++) {
-        if (keys[i] == impl->x11KeyTable[(std::size_t)key]) return true;
-        else if (i == 0) break;
-    }
-    
-    return false;
+    return keys[x11KeyCode / 8] & (1 << (x11KeyCode % 8));
 }
 
 bool esd::wnd::Window::isKeyToggled(Key key) {
@@ -557,6 +771,45 @@ void esd::wnd::Window::setCursorScreenPos(CursorPos pos) {
     );
 }
 
+bool esd::wnd::Window::isCursorLocked() {
+    return impl->cursorLocked;
+}
+
+void esd::wnd::Window::setCursorLocked(bool locked) {
+    if (impl->cursorLocked == locked) return;
+    impl->cursorLocked = locked;
+
+    if (locked) {
+        // Blank 1x1 cursor to hide the pointer
+        if (impl->invisibleCursor == None) {
+            char data = 0;
+            XColor black = {};
+            Pixmap pixmap = XCreateBitmapFromData(impl->display, impl->window, &data, 1, 1);
+            impl->invisibleCursor = XCreatePixmapCursor(impl->display, pixmap, pixmap, &black, &black, 0, 0);
+            XFreePixmap(impl->display, pixmap);
+        }
+        XDefineCursor(impl->display, impl->window, impl->invisibleCursor);
+
+        CursorPos pos = getCursorPos();
+        impl->lastLockedX = static_cast<int>(pos.x);
+        impl->lastLockedY = static_cast<int>(pos.y);
+        impl->recentring = false;
+
+        impl->grabLockedPointer();
+    } else {
+        XUngrabPointer(impl->display, CurrentTime);
+        XUndefineCursor(impl->display, impl->window);
+    }
+
+    impl->rawMotionSamples.clear();
+    impl->selectXInput2Events();
+    XFlush(impl->display);
+}
+
+void esd::wnd::Window::setGamepads(Gamepads* gamepads) {
+    impl->gamepads = gamepads;
+}
+
 bool esd::wnd::Window::isMouseButtonDown(MouseButton button) {
     ::Window child, root;
     int rootX, rootY;
@@ -586,43 +839,400 @@ bool esd::wnd::Window::isMouseButtonDown(MouseButton button) {
     throw std::runtime_error("Unknown mouse button");
 }
 
-Key esd::wnd::Window::Impl::fromX11KeyCode(unsigned int x11KeyCode) {
-    if (x11KeyCode > (unsigned int)Key::LastKey)
-        return Key::Unknown;
+void esd::wnd::Window::Impl::grabLockedPointer() {
+    XGrabPointer(
+        display,
+        window,
+        True,
+        PointerMotionMask | ButtonPressMask | ButtonReleaseMask,
+        GrabModeAsync,
+        GrabModeAsync,
+        window, // Confine to the window
+        invisibleCursor,
+        CurrentTime
+    );
+}
+
+void esd::wnd::Window::Impl::handleButton(esd::wnd::Window& owner, unsigned int button, bool down) {
+    
+    // Legacy scroll wheel buttons, counted on press only
+    constexpr double delta = 1.0;
+    switch (button) {
+    case Button4:
+    case Button5:
+    case 6:
+    case 7:
+        if (!down) return;
+        if (button == Button4) pendingVScroll += delta;
+        if (button == Button5) pendingVScroll -= delta;
+        if (button == 6) pendingHScroll -= delta;
+        if (button == 7) pendingHScroll += delta;
+        return;
+    }
+
+    if (owner.mouseButtonHandler) {
+        MouseButtonEvent event;
+        event.down = down;
+        switch (button) {
+        case Button1:
+            event.button = MouseButton::LButton;
+            break;
+        case Button2:
+            event.button = MouseButton::MButton;
+            break;
+        case Button3:
+            event.button = MouseButton::RButton;
+            break;
+        default:
+            event.button = MouseButton::Unknown;
+        }
 
-    return esdKeyTable[x11KeyCode];
+        if (event.button != MouseButton::Unknown)
+            owner.mouseButtonHandler(event);
+    }
 }
 
-void esd::wnd::Window::Impl::initKeyTables() {
+void esd::wnd::Window::Impl::handleMotion(
+    esd::wnd::Window& owner, 
+    double x, 
+    double y, 
+    double rootX, 
+    double rootY, 
+    Time time
+) {
+    if (cursorLocked) {
+        handleLockedMotion(static_cast<int>(x), static_cast<int>(y), time);
+        return;
+    }
+
+    if (owner.cursorMoveHandler) {
+        CursorMoveEvent event;
+        event.pos = { x, y };
+        event.screenPos = { rootX, rootY };
 
-    // Get list of XKB names and their associated key codes for the current
-    // environment
-    XkbDescPtr desc = XkbGetMap(display, 0, XkbUseCoreKbd);
-    XkbGetNames(display, XkbKeyNamesMask, desc);
+        // The cursor has entered the window if it was previously out
+        event.entered = !cursorInWindow;
+        
+        owner.cursorMoveHandler(event);
+    }
+    cursorInWindow = true;
+}
 
-    // Size key lookup tables to fit all the possible keys
-    esdKeyTable.resize(desc->max_key_code + 1);
-    x11KeyTable.resize(desc->max_key_code + 1);
+void esd::wnd::Window::Impl::handleLeave(esd::wnd::Window& owner) {
+    cursorInWindow = false;
+    if (owner.cursorExitHandler) owner.cursorExitHandler({});
+}
 
-    for (unsigned int x11KeyCode = 0; x11KeyCode <= desc->max_key_code; x11KeyCode++) {
+void esd::wnd::Window::Impl::handleLockedMotion(int x, int y, Time time) {
+    
+    // Without raw events, use the motion relative to the previous position
+    if (xiOpcode == -1 && focused) {
+        int centerX = width / 2;
+        int centerY = height / 2;
         
-        bool found = false;
-        for (auto it : keyMappings) {
-            if (strncmp(it.first, desc->names->keys[x11KeyCode].name, XkbKeyNameLength) == 0) {
-
-                esdKeyTable[x11KeyCode] = it.second;
-                x11KeyTable[(std::size_t)it.second] = x11KeyCode;
-                
-                found = true;
-                break;
+        if (recentring && x == centerX && y == centerY) {
+            recentring = false;
+        } else {
+            RawMotionSample sample;
+            sample.dx = static_cast<double>(x - lastLockedX);
+            sample.dy = static_cast<double>(y - lastLockedY);
+            sample.time = static_cast<std::uint32_t>(time);
+            rawMotionSamples.push_back(sample);
+        }
+    }
+
+    lastLockedX = x;
+    lastLockedY = y;
+
+    // Only warp once the pointer strays out of the inner half of the window,
+    // instead of every frame
+    int marginX = width / 4;
+    int marginY = height / 4;
+    if (
+        x < marginX || x >= width - marginX ||
+        y < marginY || y >= height - marginY
+    ) {
+        XWarpPointer(display, None, window, 0, 0, 0, 0, width / 2, height / 2);
+        lastLockedX = width / 2;
+        lastLockedY = height / 2;
+        recentring = true;
+    }
+}
+
+void esd::wnd::Window::Impl::createInputContext(esd::wnd::Window* owner) {
+    
+    // Only real input methods can compose inline
+    bool preeditCallbacks = false;
+    if (hasInputMethod) {
+        XIMStyles* styles = nullptr;
+        if (XGetIMValues(im, XNQueryInputStyle, &styles, nullptr) == nullptr && styles) {
+            for (unsigned short i = 0; i < styles->count_styles; i++) {
+                if (styles->supported_styles[i] == (XIMPreeditCallbacks | XIMStatusNothing))
+                    preeditCallbacks = true;
             }
+            XFree(styles);
+        }
+    }
+
+    if (!preeditCallbacks) {
+        ic = XCreateIC(
+            im,
+            XNInputStyle,
+            XIMPreeditNothing | XIMStatusNothing,
+            XNClientWindow,
+            window,
+            XNFocusWindow,
+            window,
+            nullptr
+        );
+        return;
+    }
+
+    auto clientData = reinterpret_cast<XPointer>(owner);
+    preeditStartCallback = { clientData, onPreeditStart };
+    preeditDoneCallback = { clientData, onPreeditDone };
+    preeditDrawCallback = { clientData, onPreeditDraw };
+    preeditCaretCallback = { clientData, onPreeditCaret };
+
+    XVaNestedList preeditAttributes = XVaCreateNestedList(
+        0,
+        XNPreeditStartCallback,
+        &preeditStartCallback,
+        XNPreeditDoneCallback,
+        &preeditDoneCallback,
+        XNPreeditDrawCallback,
+        &preeditDrawCallback,
+        XNPreeditCaretCallback,
+        &preeditCaretCallback,
+        nullptr
+    );
+
+    ic = XCreateIC(
+        im,
+        XNInputStyle,
+        XIMPreeditCallbacks | XIMStatusNothing,
+        XNClientWindow,
+        window,
+        XNFocusWindow,
+        window,
+        XNPreeditAttributes,
+        preeditAttributes,
+        nullptr
+    );
+
+    XFree(preeditAttributes);
+}
+
+void esd::wnd::Window::Impl::appendXimText(const XIMText& text, std::string& out) {
+    char utf8[4];
+    
+    if (text.encoding_is_wchar) {
+        if (!text.string.wide_char) return;
+        for (unsigned short i = 0; i < text.length; i++)
+            out.append(utf8, encodeUtf8(static_cast<char32_t>(text.string.wide_char[i]), utf8));
+        return;
+    }
+
+    if (!text.string.multi_byte) return;
+    
+    // Multibyte text is in the locale's encoding
+    std::mbstate_t state = {};
+    const char* in = text.string.multi_byte;
+    std::size_t remaining = std::strlen(in);
+    for (unsigned short i = 0; i < text.length && remaining > 0; i++) {
+        wchar_t wide;
+        std::size_t size = std::mbrtowc(&wide, in, remaining, &state);
+        if (size == 0 || size == static_cast<std::size_t>(-1) || size == static_cast<std::size_t>(-2)) break;
+        out.append(utf8, encodeUtf8(static_cast<char32_t>(wide), utf8));
+        in += size;
+        remaining -= size;
+    }
+}
+
+int esd::wnd::Window::Impl::onPreeditStart(XIC ic, XPointer clientData, XPointer callData) {
+    auto owner = reinterpret_cast<esd::wnd::Window*>(clientData);
+    owner->impl->preeditLength = 0;
+    owner->impl->preeditCaret = 0;
+    return -1; // No length limit
+}
+
+void esd::wnd::Window::Impl::onPreeditDone(XIM im, XPointer clientData, XPointer callData) {
+    auto owner = reinterpret_cast<esd::wnd::Window*>(clientData);
+    Impl& impl = *owner->impl;
+
+    if (owner->preeditHandler) {
+        PreeditEvent event = {};
+        event.changeStart = 0;
+        event.changeLength = impl.preeditLength;
+        event.done = true;
+        owner->preeditHandler(event);
+    }
+
+    impl.preeditLength = 0;
+    impl.preeditCaret = 0;
+}
+
+void esd::wnd::Window::Impl::onPreeditDraw(XIM im, XPointer clientData, XPointer callData) {
+    auto owner = reinterpret_cast<esd::wnd::Window*>(clientData);
+    auto draw = reinterpret_cast<XIMPreeditDrawCallbackStruct*>(callData);
+    Impl& impl = *owner->impl;
+
+    // Input methods can send changes past the end of the pre-edit text as
+    // tracked here, e.g. after a missed start, so they're clamped to it
+    std::size_t changeStart = std::clamp<long>(draw->chg_first, 0, impl.preeditLength);
+    std::size_t changeEnd = std::clamp<long>(
+        static_cast<long>(draw->chg_first) + draw->chg_length, changeStart, impl.preeditLength
+    );
+    std::size_t insertedLength = draw->text ? draw->text->length : 0;
+    impl.preeditLength = impl.preeditLength - (changeEnd - changeStart) + insertedLength;
+    impl.preeditCaret = std::clamp<long>(draw->caret, 0, impl.preeditLength);
+
+    if (owner->preeditHandler) {
+        impl.preeditText.clear();
+        if (draw->text) appendXimText(*draw->text, impl.preeditText);
+
+        PreeditEvent event = {};
+        event.changeStart = changeStart;
+        event.changeLength = changeEnd - changeStart;
+        event.text = impl.preeditText;
+        event.caret = impl.preeditCaret;
+        owner->preeditHandler(event);
+    }
+}
+
+void esd::wnd::Window::Impl::onPreeditCaret(XIM im, XPointer clientData, XPointer callData) {
+    auto owner = reinterpret_cast<esd::wnd::Window*>(clientData);
+    auto caret = reinterpret_cast<XIMPreeditCaretCallbackStruct*>(callData);
+    Impl& impl = *owner->impl;
+
+    switch (caret->direction) {
+    case XIMAbsolutePosition:
+        impl.preeditCaret = std::clamp<long>(caret->position, 0, impl.preeditLength);
+        break;
+    case XIMForwardChar:
+        if (impl.preeditCaret < impl.preeditLength) impl.preeditCaret++;
+        break;
+    case XIMBackwardChar:
+        if (impl.preeditCaret > 0) impl.preeditCaret--;
+        break;
+    case XIMLineStart:
+        impl.preeditCaret = 0;
+        break;
+    case XIMLineEnd:
+        impl.preeditCaret = impl.preeditLength;
+        break;
+    default:
+        break;
+    }
+
+    // Tell the input method where the caret ended up
+    caret->position = static_cast<int>(impl.preeditCaret);
+
+    if (owner->preeditHandler) {
+        PreeditEvent event = {};
+        event.changeStart = impl.preeditCaret;
+        event.caret = impl.preeditCaret;
+        owner->preeditHandler(event);
+    }
+}
+
+std::string_view esd::wnd::Window::Impl::translateKeyPress(XEvent& xe) {
+    codePoints.clear();
+
+    // Without an input method, the key table gives the same result as
+    // Xutf8LookupString for most keys, without the cost of going through Xlib
+    if (!hasInputMethod && !composing) {
+        char32_t codePoint = keyTable->translateKey(xe.xkey.keycode, xe.xkey.state);
+        
+        if (codePoint != KeyTable::inputMethodOnly) {
+            std::size_t length = encodeUtf8(codePoint, lookupBuffer.data());
+            if (codePoint == 0 || length == 0) return {};
+
+            codePoints.push_back(codePoint);
+            return { lookupBuffer.data(), length };
         }
         
-        // Any character with no corresponding esd key will be set to unknown
-        if (!found) esdKeyTable[x11KeyCode] = Key::Unknown;
+        // Let the built-in input method handle the rest of the sequence
+        composing = true;
     }
 
-    // Clean up desc and its key name list
-    XkbFreeNames(desc, XkbKeyNamesMask, True);
-    XkbFreeKeyboard(desc, 0, True);
-}
\ No newline at end of file
+    if (XFilterEvent(&xe, None)) return {};
+
+    std::string_view text = lookupText(xe.xkey);
+    if (!text.empty()) composing = false;
+
+    // Only pass on the valid part of the text
+    return text.substr(0, decodeUtf8(text, codePoints));
+}
+
+std::string_view esd::wnd::Window::Impl::lookupText(XKeyEvent& xkey) {
+    Status status;
+    KeySym keySym;
+    int length = Xutf8LookupString(ic, &xkey, lookupBuffer.data(), lookupBuffer.size(), &keySym, &status);
+
+    // Long input method commits won't fit, the required size is returned
+    if (status == XBufferOverflow) {
+        lookupBuffer.resize(length);
+        length = Xutf8LookupString(ic, &xkey, lookupBuffer.data(), lookupBuffer.size(), &keySym, &status);
+    }
+
+    if (status != XLookupChars && status != XLookupBoth) return {};
+
+    return { lookupBuffer.data(), static_cast<std::size_t>(length) };
+}
+
+bool esd::wnd::Window::Impl::isRealInputMethod(const char* localeModifiers) {
+    if (localeModifiers == nullptr) return false;
+
+    const char* im = std::strstr(localeModifiers, "@im=");
+    if (im == nullptr) return false;
+    im += std::strlen("@im=");
+
+    // The name ends at the next modifier
+    std::size_t length = std::strcspn(im, "@");
+    std::string_view name(im, length);
+    
+    return !name.empty() && name != "none" && name != "local";
+}
+
+void esd::wnd::Window::Impl::setBypassCompositor(bool bypass) {
+    // 1 asks for compositing to be turned off, without the property the
+    // compositor decides
+    if (bypass) {
+        unsigned long value = 1;
+        XChangeProperty(
+            display, window, _NET_WM_BYPASS_COMPOSITOR, XA_CARDINAL, 32, PropModeReplace,
+            reinterpret_cast<unsigned char*>(&value), 1
+        );
+    } else {
+        XDeleteProperty(display, window, _NET_WM_BYPASS_COMPOSITOR);
+    }
+}
+
+Rect esd::wnd::Window::Impl::getMonitorRect(int x, int y) {
+    Rect rect = { 0, 0, DisplayWidth(display, screen), DisplayHeight(display, screen) };
+
+#ifdef ESD_WND_HAS_XRANDR
+    XRRScreenResources* resources = XRRGetScreenResourcesCurrent(display, root);
+    if (!resources) return rect;
+
+    // Outside every CRTC, the first one is used
+    bool found = false, any = false;
+    for (int i = 0; i < resources->ncrtc && !found; i++) {
+        XRRCrtcInfo* crtc = XRRGetCrtcInfo(display, resources, resources->crtcs[i]);
+        if (!crtc) continue;
+
+        if (crtc->mode != None) {
+            Rect crtcRect = { crtc->x, crtc->y, static_cast<int>(crtc->width), static_cast<int>(crtc->height) };
+            found = x >= crtcRect.x && x < crtcRect.x + crtcRect.w && y >= crtcRect.y && y < crtcRect.y + crtcRect.h;
+            if (found || !any) rect = crtcRect;
+            any = true;
+        }
+        XRRFreeCrtcInfo(crtc);
+    }
+
+    XRRFreeScreenResources(resources);
+#endif
+
+    return rect;
+}
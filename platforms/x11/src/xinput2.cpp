@@ -0,0 +1,429 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#include "impl.hpp"
+#include <algorithm>
+
+using namespace esd::wnd;
+
+#ifdef ESD_WND_HAS_XINPUT2
+
+void esd::wnd::Window::Impl::findValuator(const XIDeviceInfo& device, Atom label, ValuatorRange& range) {
+    for (int i = 0; i < device.num_classes; i++) {
+        if (device.classes[i]->type != XIValuatorClass) continue;
+        auto valuator = reinterpret_cast<XIValuatorClassInfo*>(device.classes[i]);
+        if (valuator->label != label || valuator->max <= valuator->min) continue;
+        range.number = valuator->number;
+        range.min = valuator->min;
+        range.max = valuator->max;
+    }
+}
+
+bool esd::wnd::Window::Impl::readValuator(const XIValuatorState& valuators, const ValuatorRange& range, double& out) {
+    // Values are packed, only present for valuators set in the mask
+    if (range.number == -1 || range.number >= valuators.mask_len * 8) return false;
+    if (!XIMaskIsSet(valuators.mask, range.number)) return false;
+
+    const double* value = valuators.values;
+    for (int i = 0; i < range.number; i++) {
+        if (XIMaskIsSet(valuators.mask, i)) value++;
+    }
+    out = (*value - range.min) / (range.max - range.min);
+    return true;
+}
+
+void esd::wnd::Window::Impl::addPenSample(const XIDeviceEvent& device) {
+    auto penDevice = std::find_if(penDevices.begin(), penDevices.end(), 
+        [&](const PenDevice& pen) { return pen.deviceId == device.sourceid; });
+    if (penDevice == penDevices.end()) return;
+
+    // Pressure, and tilt mapped to [-1, 1], keep their last value when a
+    // sample doesn't change them
+    PenSample sample = {};
+    if (!penSamples.empty()) sample = penSamples.back();
+    else sample = lastPenSample;
+
+    sample.x = device.event_x;
+    sample.y = device.event_y;
+    sample.time = static_cast<std::uint32_t>(device.time);
+    readValuator(device.valuators, penDevice->pressure, sample.pressure);
+    if (readValuator(device.valuators, penDevice->tiltX, sample.tiltX)) sample.tiltX = sample.tiltX * 2.0 - 1.0;
+    if (readValuator(device.valuators, penDevice->tiltY, sample.tiltY)) sample.tiltY = sample.tiltY * 2.0 - 1.0;
+    
+    penSamples.push_back(sample);
+}
+
+void esd::wnd::Window::Impl::initXInput2() {
+    int event, error;
+    if (!XQueryExtension(display, "XInputExtension", &xiOpcode, &event, &error)) {
+        xiOpcode = -1;
+        return;
+    }
+
+    // Ask for the newest version used by any feature, the server answers with
+    // the version it actually supports
+    int major = 2;
+    int minor = 2;
+    if (XIQueryVersion(display, &major, &minor) != Success || major < 2) {
+        xiOpcode = -1;
+        return;
+    }
+    xiMinorVersion = minor;
+
+    ABS_MT_PRESSURE = XInternAtom(display, "Abs MT Pressure", False);
+    ABS_PRESSURE = XInternAtom(display, "Abs Pressure", False);
+    ABS_TILT_X = XInternAtom(display, "Abs Tilt X", False);
+    ABS_TILT_Y = XInternAtom(display, "Abs Tilt Y", False);
+
+    updateXInput2Devices();
+    selectXInput2Events();
+}
+
+void esd::wnd::Window::Impl::selectXInput2Events() {
+    if (xiOpcode == -1) return;
+
+    // Raw events are only ever delivered to the root window
+    // Every physical movement is reported by both the slave device and its
+    // master, so raw motion only comes from masters, while device changes
+    // come from every device
+    unsigned char rootMask[XIMaskLen(XI_LASTEVENT)] = {};
+    XISetMask(rootMask, XI_HierarchyChanged);
+    XISetMask(rootMask, XI_DeviceChanged);
+
+    unsigned char rootMasterMask[XIMaskLen(XI_LASTEVENT)] = {};
+    if (rawMotionEnabled || cursorLocked) XISetMask(rootMasterMask, XI_RawMotion);
+
+    // An empty mask is still selected, to clear a previous one
+    XIEventMask rootMasks[2];
+    rootMasks[0].deviceid = XIAllDevices;
+    rootMasks[0].mask_len = sizeof(rootMask);
+    rootMasks[0].mask = rootMask;
+    rootMasks[1].deviceid = XIAllMasterDevices;
+    rootMasks[1].mask_len = sizeof(rootMasterMask);
+    rootMasks[1].mask = rootMasterMask;
+    XISelectEvents(display, root, rootMasks, 2);
+
+    // Scroll valuators need XInput 2.1
+    // Selecting pointer events on the window replaces the core events for it,
+    // apart from during core grabs
+    if (xiMinorVersion >= 1) {
+        unsigned char windowMask[XIMaskLen(XI_LASTEVENT)] = {};
+        XISetMask(windowMask, XI_Motion);
+        XISetMask(windowMask, XI_ButtonPress);
+        XISetMask(windowMask, XI_ButtonRelease);
+        XISetMask(windowMask, XI_Enter);
+        XISetMask(windowMask, XI_Leave);
+
+        // Touch events need XInput 2.2, and must be selected together
+        if (xiMinorVersion >= 2) {
+            XISetMask(windowMask, XI_TouchBegin);
+            XISetMask(windowMask, XI_TouchUpdate);
+            XISetMask(windowMask, XI_TouchEnd);
+        }
+
+        XIEventMask eventMask;
+        eventMask.deviceid = XIAllMasterDevices;
+        eventMask.mask_len = sizeof(windowMask);
+        eventMask.mask = windowMask;
+        XISelectEvents(display, window, &eventMask, 1);
+    }
+}
+
+void esd::wnd::Window::Impl::updateXInput2Devices() {
+    absolutePointers.clear();
+    scrollValuators.clear();
+    touchDevices.clear();
+    penDevices.clear();
+
+    int deviceCount;
+    XIDeviceInfo* devices = XIQueryDevice(display, XIAllDevices, &deviceCount);
+    if (!devices) return;
+
+    for (int i = 0; i < deviceCount; i++) {
+        const XIDeviceInfo& device = devices[i];
+        if (device.use != XISlavePointer) continue;
+
+        for (int j = 0; j < device.num_classes; j++) {
+            if (device.classes[j]->type != XITouchClass) continue;
+
+            TouchDevice touchDevice = {};
+            touchDevice.deviceId = device.deviceid;
+            findValuator(device, ABS_MT_PRESSURE, touchDevice.pressure);
+            touchDevices.push_back(touchDevice);
+        }
+
+        // Touchscreens can also report single touch pressure, and their
+        // samples are already covered by touch frames
+        bool touch = !touchDevices.empty() && touchDevices.back().deviceId == device.deviceid;
+
+        PenDevice penDevice = {};
+        penDevice.deviceId = device.deviceid;
+        findValuator(device, ABS_PRESSURE, penDevice.pressure);
+        findValuator(device, ABS_TILT_X, penDevice.tiltX);
+        findValuator(device, ABS_TILT_Y, penDevice.tiltY);
+        if (!touch && penDevice.pressure.number != -1) penDevices.push_back(penDevice);
+
+        for (int j = 0; j < device.num_classes; j++) {
+            if (device.classes[j]->type != XIValuatorClass) continue;
+            auto valuator = reinterpret_cast<XIValuatorClassInfo*>(device.classes[j]);
+            if (valuator->number == 0 && valuator->mode == XIModeAbsolute) 
+                absolutePointers.push_back(device.deviceid);
+        }
+
+        for (int j = 0; j < device.num_classes; j++) {
+            if (device.classes[j]->type != XIScrollClass) continue;
+            auto scroll = reinterpret_cast<XIScrollClassInfo*>(device.classes[j]);
+            
+            ScrollValuator scrollValuator = {};
+            scrollValuator.deviceId = device.deviceid;
+            scrollValuator.number = scroll->number;
+            scrollValuator.vertical = scroll->scroll_type == XIScrollTypeVertical;
+            scrollValuator.increment = scroll->increment != 0.0 ? scroll->increment : 1.0;
+
+            // Start from the current value of the matching valuator
+            for (int k = 0; k < device.num_classes; k++) {
+                if (device.classes[k]->type != XIValuatorClass) continue;
+                auto valuator = reinterpret_cast<XIValuatorClassInfo*>(device.classes[k]);
+                if (valuator->number != scroll->number) continue;
+                scrollValuator.value = valuator->value;
+                scrollValuator.valueValid = true;
+            }
+
+            scrollValuators.push_back(scrollValuator);
+        }
+    }
+
+    XIFreeDeviceInfo(devices);
+}
+
+void esd::wnd::Window::Impl::handleXInput2Event(esd::wnd::Window& owner, XGenericEventCookie& cookie) {
+    switch (cookie.evtype) {
+    case XI_HierarchyChanged:
+        updateXInput2Devices();
+        break;
+    case XI_DeviceChanged:
+        {
+            auto changed = static_cast<XIDeviceChangedEvent*>(cookie.data);
+
+            // Devices are tracked per slave, so only a slave whose classes
+            // changed needs another query
+            if (changed->reason == XIDeviceChange) {
+                updateXInput2Devices();
+                break;
+            }
+
+            // A master switching to another slave, e.g. from a mouse to a
+            // touchpad, carries the new slave's current valuator values,
+            // which resync its scroll valuators without a round trip
+            for (int i = 0; i < changed->num_classes; i++) {
+                if (changed->classes[i]->type != XIValuatorClass) continue;
+                auto valuator = reinterpret_cast<XIValuatorClassInfo*>(changed->classes[i]);
+                for (auto& scrollValuator : scrollValuators) {
+                    if (scrollValuator.deviceId != changed->sourceid || scrollValuator.number != valuator->number) continue;
+                    scrollValuator.value = valuator->value;
+                    scrollValuator.valueValid = true;
+                }
+            }
+        }
+        break;
+    case XI_Motion:
+        {
+            auto device = static_cast<XIDeviceEvent*>(cookie.data);
+            
+            // Scroll valuators are absolute, turn them into deltas in units
+            // of wheel clicks
+            // X11 scrolls down with increasing values, opposite to vScroll
+            const double* value = device->valuators.values;
+            for (int i = 0; i < device->valuators.mask_len * 8; i++) {
+                if (!XIMaskIsSet(device->valuators.mask, i)) continue;
+                
+                for (auto& scrollValuator : scrollValuators) {
+                    if (scrollValuator.deviceId != device->sourceid || scrollValuator.number != i) continue;
+
+                    if (scrollValuator.valueValid) {
+                        double delta = (*value - scrollValuator.value) / scrollValuator.increment;
+                        if (scrollValuator.vertical) pendingVScroll -= delta;
+                        else pendingHScroll += delta;
+                    }
+                    scrollValuator.value = *value;
+                    scrollValuator.valueValid = true;
+                }
+                value++;
+            }
+
+            addPenSample(*device);
+
+            // Pure scroll events don't move the pointer
+            if (!cursorInWindow || device->event_x != lastPointerX || device->event_y != lastPointerY) {
+                handleMotion(owner, device->event_x, device->event_y, device->root_x, device->root_y, device->time);
+            }
+            lastPointerX = device->event_x;
+            lastPointerY = device->event_y;
+        }
+        break;
+    case XI_ButtonPress:
+    case XI_ButtonRelease:
+        {
+            auto device = static_cast<XIDeviceEvent*>(cookie.data);
+
+            // Wheel buttons emulated from scroll valuators were already
+            // counted by the smooth scroll deltas
+            bool wheelButton = device->detail >= Button4 && device->detail <= 7;
+            if (wheelButton && (device->flags & XIPointerEmulated)) break;
+
+            addPenSample(*device);
+            handleButton(owner, device->detail, cookie.evtype == XI_ButtonPress);
+        }
+        break;
+    case XI_TouchBegin:
+    case XI_TouchUpdate:
+    case XI_TouchEnd:
+        {
+            auto device = static_cast<XIDeviceEvent*>(cookie.data);
+            auto id = static_cast<std::uint32_t>(device->detail);
+            
+            TouchPhase phase = TouchPhase::Moved;
+            if (cookie.evtype == XI_TouchBegin) phase = TouchPhase::Began;
+            if (cookie.evtype == XI_TouchEnd) phase = TouchPhase::Ended;
+
+            // Normalized pressure, if this device reports it
+            double pressure = 1.0;
+            for (const auto& touchDevice : touchDevices) {
+                if (touchDevice.deviceId == device->sourceid)
+                    readValuator(device->valuators, touchDevice.pressure, pressure);
+            }
+
+            // Coalesce movement into the touch's entry in this frame, unless
+            // it already ended
+            if (phase == TouchPhase::Moved) {
+                for (std::size_t i = touchIds.size(); i-- > 0;) {
+                    if (touchIds[i] != id) continue;
+                    if (touchPhases[i] == TouchPhase::Ended) break;
+                    touchX[i] = device->event_x;
+                    touchY[i] = device->event_y;
+                    touchPressure[i] = pressure;
+                    return;
+                }
+            }
+
+            touchIds.push_back(id);
+            touchPhases.push_back(phase);
+            touchX.push_back(device->event_x);
+            touchY.push_back(device->event_y);
+            touchPressure.push_back(pressure);
+        }
+        break;
+    case XI_Enter:
+        // Scroll valuators may have changed while the pointer was elsewhere
+        for (auto& scrollValuator : scrollValuators) scrollValuator.valueValid = false;
+        break;
+    case XI_Leave:
+        handleLeave(owner);
+        break;
+    case XI_RawMotion:
+        {
+            auto raw = static_cast<XIRawEvent*>(cookie.data);
+
+            // Absolute devices like tablets report positions, not deltas
+            if ((!rawMotionEnabled && !cursorLocked) || !focused) break;
+            if (std::find(absolutePointers.begin(), absolutePointers.end(), raw->sourceid) != absolutePointers.end())
+                break;
+
+            // Values are packed, only present for valuators set in the mask
+            RawMotionSample sample = {};
+            sample.time = static_cast<std::uint32_t>(raw->time);
+            const double* value = raw->raw_values;
+            for (int i = 0; i < raw->valuators.mask_len * 8 && i < 2; i++) {
+                if (!XIMaskIsSet(raw->valuators.mask, i)) continue;
+                if (i == 0) sample.dx = *value;
+                else sample.dy = *value;
+                value++;
+            }
+
+            rawMotionSamples.push_back(sample);
+        }
+        break;
+    }
+}
+
+#else
+
+void esd::wnd::Window::Impl::initXInput2() { xiOpcode = -1; }
+void esd::wnd::Window::Impl::selectXInput2Events() {}
+void esd::wnd::Window::Impl::updateXInput2Devices() {}
+void esd::wnd::Window::Impl::handleXInput2Event(esd::wnd::Window& owner, XGenericEventCookie& cookie) {}
+
+#endif
+
+void esd::wnd::Window::Impl::flushXInput2Events(esd::wnd::Window& owner) {
+    if (!touchIds.empty()) {
+        if (owner.touchFrameHandler) {
+            TouchFrameEvent event;
+            event.count = touchIds.size();
+            event.ids = touchIds.data();
+            event.phases = touchPhases.data();
+            event.x = touchX.data();
+            event.y = touchY.data();
+            event.pressure = touchPressure.data();
+            owner.touchFrameHandler(event);
+        }
+        touchIds.clear();
+        touchPhases.clear();
+        touchX.clear();
+        touchY.clear();
+        touchPressure.clear();
+    }
+
+    if (!penSamples.empty()) {
+        if (owner.penHandler) {
+            PenEvent event;
+            event.samples = penSamples.data();
+            event.sampleCount = penSamples.size();
+            owner.penHandler(event);
+        }
+        lastPenSample = penSamples.back();
+        penSamples.clear();
+    }
+
+    if (!rawMotionSamples.empty()) {
+        if (owner.rawMotionHandler) {
+            RawMotionEvent event;
+            event.samples = rawMotionSamples.data();
+            event.sampleCount = rawMotionSamples.size();
+            owner.rawMotionHandler(event);
+        }
+        rawMotionSamples.clear();
+    }
+}
+
+bool esd::wnd::Window::isRawMotionSupported() {
+    return impl->xiOpcode != -1;
+}
+
+bool esd::wnd::Window::isRawMotionEnabled() {
+    return impl->rawMotionEnabled;
+}
+
+void esd::wnd::Window::setRawMotionEnabled(bool enabled) {
+    if (!isRawMotionSupported() || impl->rawMotionEnabled == enabled) return;
+    impl->rawMotionEnabled = enabled;
+    impl->rawMotionSamples.clear();
+    impl->selectXInput2Events();
+}
@@ -0,0 +1,111 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#include "framemailbox.hpp"
+#include <algorithm>
+
+using namespace esd::wnd;
+
+PixelBuffer FrameMailbox::acquire(int width, int height) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Acquiring again before submitting returns the same frame
+    if (drawing == -1) {
+        for (int i = 0; i < 3; i++) {
+            if (i != waiting && i != presenting) {
+                drawing = i;
+                break;
+            }
+        }
+    }
+
+    Frame& frame = frames[drawing];
+    frame.width = std::max(width, 0);
+    frame.height = std::max(height, 0);
+    frame.pixels.resize(frame.width * getBytesPerPixel(format) * frame.height);
+    return getBuffer(drawing);
+}
+
+void FrameMailbox::submit() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (error) std::rethrow_exception(error);
+    if (drawing == -1) return;
+
+    frames[drawing].submitTime = Clock::now();
+    if (waiting != -1) stats.replaced++;
+    waiting = drawing;
+    drawing = -1;
+    stats.submitted++;
+    frameWaiting.notify_one();
+}
+
+bool FrameMailbox::take(PixelBuffer& frame) {
+    std::unique_lock<std::mutex> lock(mutex);
+    frameWaiting.wait(lock, [&] { return waiting != -1 || stopped; });
+    if (stopped) return false;
+
+    presenting = waiting;
+    waiting = -1;
+    frame = getBuffer(presenting);
+    return true;
+}
+
+void FrameMailbox::release() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (presenting == -1) return;
+
+    double latency = std::chrono::duration<double>(Clock::now() - frames[presenting].submitTime).count();
+    presenting = -1;
+
+    stats.presented++;
+    stats.lastLatency = latency;
+    stats.maxLatency = std::max(stats.maxLatency, latency);
+    totalLatency += latency;
+    stats.averageLatency = totalLatency / stats.presented;
+}
+
+void FrameMailbox::fail(std::exception_ptr error) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->error = error;
+    presenting = -1;
+}
+
+void FrameMailbox::stop() {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopped = true;
+    frameWaiting.notify_one();
+}
+
+PresentStats FrameMailbox::getStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+PixelBuffer FrameMailbox::getBuffer(int index) {
+    Frame& frame = frames[index];
+
+    PixelBuffer buffer;
+    buffer.data = frame.pixels.data();
+    buffer.stride = frame.width * getBytesPerPixel(format);
+    buffer.width = frame.width;
+    buffer.height = frame.height;
+    buffer.format = format;
+    return buffer;
+}
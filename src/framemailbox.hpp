@@ -0,0 +1,88 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include <eseed/window/window.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <vector>
+
+namespace esd::wnd {
+
+// Three frames handed from a thread drawing them to a thread presenting them
+// A submitted frame waits in the mailbox until the presenting thread takes
+// it, and replaces any frame still waiting there, so the drawing thread never
+// blocks and only the newest frame is presented
+class FrameMailbox {
+public:
+    explicit FrameMailbox(PixelFormat format) : format(format) {}
+    FrameMailbox(const FrameMailbox&) = delete;
+
+    // Drawing side
+    PixelBuffer acquire(int width, int height);
+    void submit();
+
+    // Presenting side
+    // Block until a frame is waiting and take it, returning false once stopped
+    bool take(PixelBuffer& frame);
+
+    // Finish presenting the taken frame, measuring its latency
+    void release();
+
+    // Stop with an error, rethrown on the drawing side by the next submit
+    void fail(std::exception_ptr error);
+
+    // Wake up and stop the presenting side
+    void stop();
+
+    PresentStats getStats();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Frame {
+        std::vector<std::uint8_t> pixels;
+        int width = 0, height = 0;
+        Clock::time_point submitTime;
+    };
+    Frame frames[3];
+    PixelFormat format;
+
+    // Frame indices, -1 if no frame is in that state
+    int drawing = -1;
+    int waiting = -1;
+    int presenting = -1;
+
+    std::mutex mutex;
+    std::condition_variable frameWaiting;
+    bool stopped = false;
+    std::exception_ptr error;
+
+    PresentStats stats = {};
+    double totalLatency = 0;
+
+    PixelBuffer getBuffer(int index);
+};
+
+}
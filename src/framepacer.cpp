@@ -0,0 +1,210 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#include <eseed/window/framepacer.hpp>
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <thread>
+
+using namespace esd::wnd;
+
+namespace {
+
+using Nanoseconds = std::chrono::nanoseconds;
+
+double toSeconds(Nanoseconds duration) {
+    return std::chrono::duration<double>(duration).count();
+}
+
+// Stateless, so one is shared by every pacer using it
+SteadyPacingClock steadyClock;
+
+}
+
+Nanoseconds SteadyPacingClock::now() {
+    return std::chrono::duration_cast<Nanoseconds>(std::chrono::steady_clock::now().time_since_epoch());
+}
+
+void SteadyPacingClock::sleep(Nanoseconds duration) {
+    std::this_thread::sleep_for(duration);
+}
+
+void SteadyPacingClock::spin() {
+    std::this_thread::yield();
+}
+
+FramePacer::FramePacer() : FramePacer(steadyClock) {}
+
+FramePacer::FramePacer(PacingClock& clock) : clock(&clock) {
+    setPeriod(0);
+    resetStats();
+}
+
+void FramePacer::setRefreshRate(double refreshRate) {
+    this->refreshRate = std::max(refreshRate, 0.0);
+    setPeriod(this->refreshRate);
+}
+
+double FramePacer::getRefreshRate() {
+    return 1e9 / period.count();
+}
+
+void FramePacer::setWakePhase(double phase) {
+    wakePhase = std::clamp(phase, 0.0, 1.0);
+}
+
+void FramePacer::setSpinDuration(Nanoseconds duration) {
+    spinDuration = std::max(duration, Nanoseconds::zero());
+}
+
+void FramePacer::syncVblank(Nanoseconds time) {
+    vblankAnchor = time;
+    anchored = true;
+}
+
+FrameInfo FramePacer::waitForFrame() {
+    Nanoseconds lead(std::llround(period.count() * wakePhase));
+    Nanoseconds now = clock->now();
+
+    // Without a measured vblank, the first frame starts right away and the
+    // ones after it keep its phase
+    if (!anchored) syncVblank(now + lead);
+
+    // The first vblank whose wake time hasn't passed yet, rounding up
+    // Division truncates towards zero, which already rounds negative offsets
+    // up
+    auto offset = (now + lead - vblankAnchor).count();
+    auto periods = offset / period.count();
+    if (offset % period.count() > 0) periods++;
+    Nanoseconds vblank = vblankAnchor + periods * period;
+
+    // Never target the same vblank twice, even if the anchor moved
+    if (continuing && vblank - lastVblank < period / 2) vblank += period;
+
+    // Sleep most of the way, then spin through the sleep's wakeup latency
+    Nanoseconds wake = vblank - lead;
+    if (wake - now > spinDuration) clock->sleep(wake - now - spinDuration);
+    while ((now = clock->now()) < wake) clock->spin();
+
+    FrameInfo info;
+    info.frame = ++frame;
+    info.time = now;
+    info.vblankTime = vblank;
+    info.deltaTime = 0;
+    info.missedVblanks = 0;
+    if (continuing) {
+        info.deltaTime = toSeconds(now - lastTime);
+        auto vblanks = std::llround(static_cast<double>((vblank - lastVblank).count()) / period.count());
+        info.missedVblanks = static_cast<std::uint32_t>(std::max(vblanks - 1, 0ll));
+    }
+    lastTime = now;
+    lastVblank = vblank;
+
+    stats.frames++;
+    stats.missedVblanks += info.missedVblanks;
+
+    double wakeError = toSeconds(now - wake);
+    totalWakeError += wakeError;
+    stats.averageWakeError = totalWakeError / stats.frames;
+    stats.maxWakeError = std::max(stats.maxWakeError, wakeError);
+
+    // Welford's running variance, for jitter without keeping frame times
+    if (continuing) {
+        frameTimeCount++;
+        double delta = info.deltaTime - frameTimeMean;
+        frameTimeMean += delta / frameTimeCount;
+        frameTimeM2 += delta * (info.deltaTime - frameTimeMean);
+        stats.averageFrameTime = frameTimeMean;
+        stats.frameTimeJitter = std::sqrt(frameTimeM2 / frameTimeCount);
+        stats.maxFrameTime = std::max(stats.maxFrameTime, info.deltaTime);
+    }
+    continuing = true;
+
+    return info;
+}
+
+void FramePacer::restart() {
+    continuing = false;
+}
+
+void FramePacer::run(Window& window, std::function<void(const FrameInfo&)> frameHandler) {
+    // The window may have moved to another monitor since the last run
+    if (refreshRate == 0) setPeriod(window.getRefreshRate());
+
+    // The vblank handler is put back when the run ends, even if a frame throws
+    struct VblankScope {
+        Window& window;
+        std::function<void(std::uint64_t)> handler;
+
+        explicit VblankScope(Window& window) : window(window), handler(window.presentVblankHandler) {}
+        VblankScope(const VblankScope&) = delete;
+
+        ~VblankScope() {
+            window.setPresentVblankHandler(handler);
+        }
+    };
+
+    // Completed presents are the only vblank times the window reports
+    std::optional<VblankScope> vblanks;
+    if (window.isPresentTimingSupported()) {
+        vblanks.emplace(window);
+        window.setPresentVblankHandler([this](std::uint64_t ust) {
+            syncVblank(std::chrono::microseconds(ust));
+        });
+    }
+
+    while (true) {
+        if (!window.isVisible()) {
+            while (!window.isVisible()) {
+                window.waitEvents();
+                if (window.isCloseRequested()) return;
+            }
+            restart();
+        }
+
+        FrameInfo info = waitForFrame();
+
+        // Input is drained as late as possible, so the frame sees the latest
+        window.poll();
+        if (window.isCloseRequested()) return;
+
+        frameHandler(info);
+    }
+}
+
+FramePacingStats FramePacer::getStats() {
+    return stats;
+}
+
+void FramePacer::resetStats() {
+    stats = {};
+    stats.period = toSeconds(period);
+    frameTimeCount = 0;
+    frameTimeMean = 0;
+    frameTimeM2 = 0;
+    totalWakeError = 0;
+}
+
+void FramePacer::setPeriod(double refreshRate) {
+    if (refreshRate <= 0) refreshRate = 60;
+    period = Nanoseconds(std::llround(1e9 / refreshRate));
+    stats.period = toSeconds(period);
+}
@@ -0,0 +1,703 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#include "simd.hpp"
+#include <eseed/window/pixels.hpp>
+#include <eseed/window/window.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+using namespace esd::wnd;
+
+namespace {
+
+bool isBytePermutation(PixelFormat format) {
+    switch (format) {
+    case PixelFormat::Rgba8888:
+    case PixelFormat::Bgra8888:
+    case PixelFormat::Rgbx8888:
+    case PixelFormat::Bgrx8888:
+    case PixelFormat::Xrgb8888:
+    case PixelFormat::Xbgr8888:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Formats with 8 bits per channel, including the ones only used as sources
+bool isBytePerChannel(PixelFormat format) {
+    return isBytePermutation(format) || format == PixelFormat::Rgba8888 || format == PixelFormat::Bgra8888;
+}
+
+// Byte of RGBA order (R, G, B, A) stored at each byte of a pixel
+void getByteOrder(PixelFormat format, std::uint8_t order[4]) {
+    std::uint8_t rgba[4] = { 0, 1, 2, 3 };
+    std::uint8_t bgra[4] = { 2, 1, 0, 3 };
+    std::uint8_t argb[4] = { 3, 0, 1, 2 };
+    std::uint8_t abgr[4] = { 3, 2, 1, 0 };
+    const std::uint8_t* selected = rgba;
+    if (format == PixelFormat::Bgra8888 || format == PixelFormat::Bgrx8888) selected = bgra;
+    if (format == PixelFormat::Xrgb8888) selected = argb;
+    if (format == PixelFormat::Xbgr8888) selected = abgr;
+    std::memcpy(order, selected, 4);
+}
+
+float halfToFloat(std::uint16_t half) {
+    std::uint32_t sign = static_cast<std::uint32_t>(half & 0x8000) << 16;
+    std::uint32_t exponent = half >> 10 & 0x1F;
+    std::uint32_t mantissa = half & 0x3FF;
+
+    // Subnormals are mantissa * 2^-24
+    if (exponent == 0) {
+        float value = mantissa * (1.0f / 16777216.0f);
+        return sign ? -value : value;
+    }
+
+    std::uint32_t bits = exponent == 31
+        ? sign | 0x7F800000 | mantissa << 13
+        : sign | (exponent + 112) << 23 | mantissa << 13;
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+float encodeSrgb(float linear) {
+    return linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+}
+
+// sRGB encoding through lookup tables, for 8 bit linear values and for floats
+// quantized to 14 bits (finer than one 8 bit step even at the steep dark end)
+constexpr int srgbFloatSteps = 16383;
+
+const std::uint8_t* getSrgbTable8() {
+    static const std::vector<std::uint8_t> table = [] {
+        std::vector<std::uint8_t> table(256);
+        for (int i = 0; i < 256; i++) table[i] = static_cast<std::uint8_t>(std::lround(encodeSrgb(i / 255.0f) * 255.0f));
+        return table;
+    }();
+    return table.data();
+}
+
+const std::uint8_t* getSrgbTableFloat() {
+    static const std::vector<std::uint8_t> table = [] {
+        std::vector<std::uint8_t> table(srgbFloatSteps + 1);
+        for (int i = 0; i <= srgbFloatSteps; i++) {
+            table[i] = static_cast<std::uint8_t>(std::lround(encodeSrgb(float(i) / srgbFloatSteps) * 255.0f));
+        }
+        return table;
+    }();
+    return table.data();
+}
+
+// Kernels convert count pixels, with separate versions per instruction set
+// where it pays off
+// Packed destination formats are written as native endian values
+
+void permuteScalar(const std::uint8_t* in, std::uint8_t* out, std::size_t count, const std::uint8_t order[4]) {
+    for (std::size_t i = 0; i < count; i++) {
+        std::uint8_t pixel[4] = { in[i * 4], in[i * 4 + 1], in[i * 4 + 2], in[i * 4 + 3] };
+        for (int j = 0; j < 4; j++) out[i * 4 + j] = pixel[order[j]];
+    }
+}
+
+void pack565Scalar(const std::uint8_t* in, std::uint16_t* out, std::size_t count) {
+    for (std::size_t i = 0; i < count; i++) {
+        const std::uint8_t* pixel = in + i * 4;
+        out[i] = static_cast<std::uint16_t>((pixel[0] >> 3) << 11 | (pixel[1] >> 2) << 5 | pixel[2] >> 3);
+    }
+}
+
+void pack2101010Scalar(const std::uint8_t* in, std::uint32_t* out, std::size_t count) {
+    // Expand 8 bits to 10 by repeating the top bits, so 255 becomes 1023
+    auto expand = [](std::uint32_t c) { return c << 2 | c >> 6; };
+    for (std::size_t i = 0; i < count; i++) {
+        const std::uint8_t* pixel = in + i * 4;
+        out[i] = expand(pixel[0]) << 20 | expand(pixel[1]) << 10 | expand(pixel[2]);
+    }
+}
+
+void halfToRgba8Scalar(const std::uint16_t* in, std::uint8_t* out, std::size_t count, bool srgb) {
+    // NaN clamps to 0
+    auto clamp = [](float value) { return value > 0.0f ? std::min(value, 1.0f) : 0.0f; };
+    const std::uint8_t* srgbTable = getSrgbTableFloat();
+    for (std::size_t i = 0; i < count * 4; i += 4) {
+        for (int j = 0; j < 3; j++) {
+            float value = clamp(halfToFloat(in[i + j]));
+            out[i + j] = srgb
+                ? srgbTable[static_cast<int>(value * srgbFloatSteps + 0.5f)]
+                : static_cast<std::uint8_t>(value * 255.0f + 0.5f);
+        }
+        out[i + 3] = static_cast<std::uint8_t>(clamp(halfToFloat(in[i + 3])) * 255.0f + 0.5f);
+    }
+}
+
+#if defined(ESD_WND_SIMD_SSE2)
+
+// Without a byte shuffle, each destination byte is shifted into place
+void permuteSse2(const std::uint8_t* in, std::uint8_t* out, std::size_t count, const std::uint8_t order[4]) {
+    const __m128i byteMask = _mm_set1_epi32(0xFF);
+    __m128i shiftIn[4];
+    __m128i shiftOut[4];
+    for (int j = 0; j < 4; j++) {
+        shiftIn[j] = _mm_cvtsi32_si128(order[j] * 8);
+        shiftOut[j] = _mm_cvtsi32_si128(j * 8);
+    }
+
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 4));
+        __m128i result = _mm_setzero_si128();
+        for (int j = 0; j < 4; j++) {
+            __m128i channel = _mm_and_si128(_mm_srl_epi32(pixels, shiftIn[j]), byteMask);
+            result = _mm_or_si128(result, _mm_sll_epi32(channel, shiftOut[j]));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4), result);
+    }
+    permuteScalar(in + i * 4, out + i * 4, count - i, order);
+}
+
+void pack565Sse2(const std::uint8_t* in, std::uint16_t* out, std::size_t count) {
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i packed[2];
+        for (int half = 0; half < 2; half++) {
+            __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + (i + half * 4) * 4));
+            __m128i r = _mm_and_si128(_mm_slli_epi32(pixels, 8), _mm_set1_epi32(0xF800));
+            __m128i g = _mm_and_si128(_mm_srli_epi32(pixels, 5), _mm_set1_epi32(0x7E0));
+            __m128i b = _mm_and_si128(_mm_srli_epi32(pixels, 19), _mm_set1_epi32(0x1F));
+
+            // Sign extend the low 16 bits, so packing with signed saturation
+            // keeps them as they are
+            __m128i value = _mm_or_si128(_mm_or_si128(r, g), b);
+            packed[half] = _mm_srai_epi32(_mm_slli_epi32(value, 16), 16);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(packed[0], packed[1]));
+    }
+    pack565Scalar(in + i * 4, out + i, count - i);
+}
+
+void pack2101010Sse2(const std::uint8_t* in, std::uint32_t* out, std::size_t count) {
+    const __m128i byteMask = _mm_set1_epi32(0xFF);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 4));
+        __m128i result = _mm_setzero_si128();
+        for (int j = 0; j < 3; j++) {
+            __m128i channel = _mm_and_si128(_mm_srl_epi32(pixels, _mm_cvtsi32_si128(j * 8)), byteMask);
+            channel = _mm_or_si128(_mm_slli_epi32(channel, 2), _mm_srli_epi32(channel, 6));
+            result = _mm_or_si128(result, _mm_sll_epi32(channel, _mm_cvtsi32_si128(20 - j * 10)));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), result);
+    }
+    pack2101010Scalar(in + i * 4, out + i, count - i);
+}
+
+#endif
+
+#if defined(ESD_WND_SIMD_AVX2)
+
+ESD_WND_TARGET_AVX2
+void permuteAvx2(const std::uint8_t* in, std::uint8_t* out, std::size_t count, const std::uint8_t order[4]) {
+    alignas(32) std::uint8_t shuffle[32];
+    for (int j = 0; j < 32; j++) shuffle[j] = static_cast<std::uint8_t>(j / 4 % 4 * 4 + order[j % 4]);
+    const __m256i mask = _mm256_load_si256(reinterpret_cast<const __m256i*>(shuffle));
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i * 4));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * 4), _mm256_shuffle_epi8(pixels, mask));
+    }
+    permuteScalar(in + i * 4, out + i * 4, count - i, order);
+}
+
+ESD_WND_TARGET_AVX2
+void pack565Avx2(const std::uint8_t* in, std::uint16_t* out, std::size_t count) {
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i packed[2];
+        for (int half = 0; half < 2; half++) {
+            __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + (i + half * 8) * 4));
+            __m256i r = _mm256_and_si256(_mm256_slli_epi32(pixels, 8), _mm256_set1_epi32(0xF800));
+            __m256i g = _mm256_and_si256(_mm256_srli_epi32(pixels, 5), _mm256_set1_epi32(0x7E0));
+            __m256i b = _mm256_and_si256(_mm256_srli_epi32(pixels, 19), _mm256_set1_epi32(0x1F));
+            packed[half] = _mm256_or_si256(_mm256_or_si256(r, g), b);
+        }
+
+        // Packing works within 128 bit lanes, so the quarters are reordered
+        // afterwards
+        __m256i result = _mm256_packus_epi32(packed[0], packed[1]);
+        result = _mm256_permute4x64_epi64(result, _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), result);
+    }
+    pack565Scalar(in + i * 4, out + i, count - i);
+}
+
+ESD_WND_TARGET_AVX2
+void pack2101010Avx2(const std::uint8_t* in, std::uint32_t* out, std::size_t count) {
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i * 4));
+        __m256i r = _mm256_and_si256(pixels, byteMask);
+        __m256i g = _mm256_and_si256(_mm256_srli_epi32(pixels, 8), byteMask);
+        __m256i b = _mm256_and_si256(_mm256_srli_epi32(pixels, 16), byteMask);
+        r = _mm256_or_si256(_mm256_slli_epi32(r, 2), _mm256_srli_epi32(r, 6));
+        g = _mm256_or_si256(_mm256_slli_epi32(g, 2), _mm256_srli_epi32(g, 6));
+        b = _mm256_or_si256(_mm256_slli_epi32(b, 2), _mm256_srli_epi32(b, 6));
+        __m256i result = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(r, 20), _mm256_slli_epi32(g, 10)), b);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), result);
+    }
+    pack2101010Scalar(in + i * 4, out + i, count - i);
+}
+
+// Linear only, sRGB encoding goes through the scalar lookup table
+ESD_WND_TARGET_AVX2
+void halfToRgba8Avx2(const std::uint16_t* in, std::uint8_t* out, std::size_t count) {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 scale = _mm256_set1_ps(255.0f);
+
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i values[2];
+        for (int half = 0; half < 2; half++) {
+            __m256 floats = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + (i + half * 2) * 4)));
+
+            // max returns its second operand for NaN, clamping it to 0
+            floats = _mm256_min_ps(_mm256_max_ps(floats, zero), one);
+            values[half] = _mm256_cvtps_epi32(_mm256_mul_ps(floats, scale));
+        }
+
+        __m256i words = _mm256_packs_epi32(values[0], values[1]);
+        words = _mm256_permute4x64_epi64(words, _MM_SHUFFLE(3, 1, 2, 0));
+        __m128i bytes = _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4), bytes);
+    }
+    halfToRgba8Scalar(in + i * 4, out + i * 4, count - i, false);
+}
+
+#endif
+
+#if defined(ESD_WND_SIMD_NEON)
+
+void permuteNeon(const std::uint8_t* in, std::uint8_t* out, std::size_t count, const std::uint8_t order[4]) {
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        uint8x16x4_t pixels = vld4q_u8(in + i * 4);
+        uint8x16x4_t result;
+        result.val[0] = pixels.val[order[0]];
+        result.val[1] = pixels.val[order[1]];
+        result.val[2] = pixels.val[order[2]];
+        result.val[3] = pixels.val[order[3]];
+        vst4q_u8(out + i * 4, result);
+    }
+    permuteScalar(in + i * 4, out + i * 4, count - i, order);
+}
+
+void pack565Neon(const std::uint8_t* in, std::uint16_t* out, std::size_t count) {
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        uint8x8x4_t pixels = vld4_u8(in + i * 4);
+        uint16x8_t r = vshlq_n_u16(vmovl_u8(vshr_n_u8(pixels.val[0], 3)), 11);
+        uint16x8_t g = vshlq_n_u16(vmovl_u8(vshr_n_u8(pixels.val[1], 2)), 5);
+        uint16x8_t b = vmovl_u8(vshr_n_u8(pixels.val[2], 3));
+        vst1q_u16(out + i, vorrq_u16(vorrq_u16(r, g), b));
+    }
+    pack565Scalar(in + i * 4, out + i, count - i);
+}
+
+void pack2101010Neon(const std::uint8_t* in, std::uint32_t* out, std::size_t count) {
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        uint8x8x4_t pixels = vld4_u8(in + i * 4);
+        uint16x8_t channels[3];
+        for (int j = 0; j < 3; j++) {
+            uint16x8_t c = vmovl_u8(pixels.val[j]);
+            channels[j] = vorrq_u16(vshlq_n_u16(c, 2), vshrq_n_u16(c, 6));
+        }
+
+        uint32x4_t low = vorrq_u32(
+            vorrq_u32(vshlq_n_u32(vmovl_u16(vget_low_u16(channels[0])), 20), vshlq_n_u32(vmovl_u16(vget_low_u16(channels[1])), 10)),
+            vmovl_u16(vget_low_u16(channels[2]))
+        );
+        uint32x4_t high = vorrq_u32(
+            vorrq_u32(vshlq_n_u32(vmovl_u16(vget_high_u16(channels[0])), 20), vshlq_n_u32(vmovl_u16(vget_high_u16(channels[1])), 10)),
+            vmovl_u16(vget_high_u16(channels[2]))
+        );
+        vst1q_u32(out + i, low);
+        vst1q_u32(out + i + 4, high);
+    }
+    pack2101010Scalar(in + i * 4, out + i, count - i);
+}
+
+#if defined(__aarch64__)
+// Linear only, sRGB encoding goes through the scalar lookup table
+void halfToRgba8Neon(const std::uint16_t* in, std::uint8_t* out, std::size_t count) {
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+
+    std::size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        uint16x4_t words[2];
+        for (int pixel = 0; pixel < 2; pixel++) {
+            float32x4_t floats = vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(in + (i + pixel) * 4)));
+
+            // maxnm and minnm return the number for NaN, clamping it to 0
+            floats = vminnmq_f32(vmaxnmq_f32(floats, zero), one);
+            words[pixel] = vmovn_u32(vcvtnq_u32_f32(vmulq_n_f32(floats, 255.0f)));
+        }
+        vst1_u8(out + i * 4, vmovn_u16(vcombine_u16(words[0], words[1])));
+    }
+    halfToRgba8Scalar(in + i * 4, out + i * 4, count - i, false);
+}
+#endif
+
+#endif
+
+void permute(const std::uint8_t* in, std::uint8_t* out, std::size_t count, const std::uint8_t order[4]) {
+    Isa isa = getIsa();
+#if defined(ESD_WND_SIMD_AVX2)
+    if (isa == Isa::Avx2) return permuteAvx2(in, out, count, order);
+#endif
+#if defined(ESD_WND_SIMD_SSE2)
+    if (isa == Isa::Sse2) return permuteSse2(in, out, count, order);
+#endif
+#if defined(ESD_WND_SIMD_NEON)
+    if (isa == Isa::Neon) return permuteNeon(in, out, count, order);
+#endif
+    permuteScalar(in, out, count, order);
+}
+
+void pack565(const std::uint8_t* in, std::uint16_t* out, std::size_t count) {
+    Isa isa = getIsa();
+#if defined(ESD_WND_SIMD_AVX2)
+    if (isa == Isa::Avx2) return pack565Avx2(in, out, count);
+#endif
+#if defined(ESD_WND_SIMD_SSE2)
+    if (isa == Isa::Sse2) return pack565Sse2(in, out, count);
+#endif
+#if defined(ESD_WND_SIMD_NEON)
+    if (isa == Isa::Neon) return pack565Neon(in, out, count);
+#endif
+    pack565Scalar(in, out, count);
+}
+
+void pack2101010(const std::uint8_t* in, std::uint32_t* out, std::size_t count) {
+    Isa isa = getIsa();
+#if defined(ESD_WND_SIMD_AVX2)
+    if (isa == Isa::Avx2) return pack2101010Avx2(in, out, count);
+#endif
+#if defined(ESD_WND_SIMD_SSE2)
+    if (isa == Isa::Sse2) return pack2101010Sse2(in, out, count);
+#endif
+#if defined(ESD_WND_SIMD_NEON)
+    if (isa == Isa::Neon) return pack2101010Neon(in, out, count);
+#endif
+    pack2101010Scalar(in, out, count);
+}
+
+void halfToRgba8(const std::uint16_t* in, std::uint8_t* out, std::size_t count, bool srgb) {
+    Isa isa = getIsa();
+    if (!srgb) {
+#if defined(ESD_WND_SIMD_AVX2)
+        if (isa == Isa::Avx2) return halfToRgba8Avx2(in, out, count);
+#endif
+#if defined(ESD_WND_SIMD_NEON) && defined(__aarch64__)
+        if (isa == Isa::Neon) return halfToRgba8Neon(in, out, count);
+#endif
+    }
+    halfToRgba8Scalar(in, out, count, srgb);
+}
+
+// Write every pixel factor times in a row, for integer scaling
+// Vector versions broadcast a pixel and store whole vectors, which can spill
+// into the following blocks before they are written; pixels whose stores
+// would go past the end of the row are written exactly
+template <typename T>
+void replicateScalar(const T* in, T* out, std::size_t count, int factor) {
+    for (std::size_t i = 0; i < count; i++) {
+        for (int j = 0; j < factor; j++) out[i * factor + j] = in[i];
+    }
+}
+
+void replicate32(const std::uint32_t* in, std::uint32_t* out, std::size_t count, int factor) {
+    if (factor == 1) {
+        std::memcpy(out, in, count * 4);
+        return;
+    }
+
+    std::size_t i = 0;
+#if defined(ESD_WND_SIMD_SSE2)
+    if (factor == 2) {
+        for (; i + 4 <= count; i += 4) {
+            __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2), _mm_unpacklo_epi32(pixels, pixels));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2 + 4), _mm_unpackhi_epi32(pixels, pixels));
+        }
+    } else {
+        std::size_t span = (factor + 3) / 4 * 4;
+        for (; i * factor + span <= count * factor; i++) {
+            __m128i pixel = _mm_set1_epi32(static_cast<int>(in[i]));
+            std::uint32_t* block = out + i * factor;
+            for (int j = 0; j < factor; j += 4) _mm_storeu_si128(reinterpret_cast<__m128i*>(block + j), pixel);
+        }
+    }
+#elif defined(ESD_WND_SIMD_NEON)
+    std::size_t span = (factor + 3) / 4 * 4;
+    for (; i * factor + span <= count * factor; i++) {
+        uint32x4_t pixel = vdupq_n_u32(in[i]);
+        std::uint32_t* block = out + i * factor;
+        for (int j = 0; j < factor; j += 4) vst1q_u32(block + j, pixel);
+    }
+#endif
+    replicateScalar(in + i, out + i * factor, count - i, factor);
+}
+
+void replicate16(const std::uint16_t* in, std::uint16_t* out, std::size_t count, int factor) {
+    if (factor == 1) {
+        std::memcpy(out, in, count * 2);
+        return;
+    }
+
+    std::size_t i = 0;
+#if defined(ESD_WND_SIMD_SSE2)
+    if (factor == 2) {
+        for (; i + 8 <= count; i += 8) {
+            __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2), _mm_unpacklo_epi16(pixels, pixels));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2 + 8), _mm_unpackhi_epi16(pixels, pixels));
+        }
+    } else {
+        std::size_t span = (factor + 7) / 8 * 8;
+        for (; i * factor + span <= count * factor; i++) {
+            __m128i pixel = _mm_set1_epi16(static_cast<short>(in[i]));
+            std::uint16_t* block = out + i * factor;
+            for (int j = 0; j < factor; j += 8) _mm_storeu_si128(reinterpret_cast<__m128i*>(block + j), pixel);
+        }
+    }
+#elif defined(ESD_WND_SIMD_NEON)
+    std::size_t span = (factor + 7) / 8 * 8;
+    for (; i * factor + span <= count * factor; i++) {
+        uint16x8_t pixel = vdupq_n_u16(in[i]);
+        std::uint16_t* block = out + i * factor;
+        for (int j = 0; j < factor; j += 8) vst1q_u16(block + j, pixel);
+    }
+#endif
+    replicateScalar(in + i, out + i * factor, count - i, factor);
+}
+
+// Nearest neighbour sampling through a map of source columns, for scales that
+// aren't whole
+template <typename T>
+void sampleRow(const T* in, T* out, const std::vector<int>& columns) {
+    for (std::size_t x = 0; x < columns.size(); x++) out[x] = in[columns[x]];
+}
+
+}
+
+std::size_t esd::wnd::getBytesPerPixel(PixelFormat format) {
+    switch (format) {
+    case PixelFormat::Unknown: return 0;
+    case PixelFormat::Rgb565: return 2;
+    case PixelFormat::Rgba16f: return 8;
+    default: return 4;
+    }
+}
+
+bool esd::wnd::isConversionSupported(PixelFormat from, PixelFormat to, bool encodeSrgb) {
+    if (from == PixelFormat::Unknown || to == PixelFormat::Unknown) return false;
+
+    // sRGB encoding works on 8 bit channels, and packed sources are never
+    // unpacked
+    if (from == to) return !encodeSrgb || isBytePerChannel(from);
+
+    bool source = from == PixelFormat::Rgba8888 || from == PixelFormat::Bgra8888 || from == PixelFormat::Rgba16f;
+    bool destination = isBytePermutation(to) || to == PixelFormat::Rgb565 || to == PixelFormat::Xrgb2101010;
+    return source && destination;
+}
+
+void esd::wnd::convertPixels(const PixelBuffer& from, const PixelBuffer& to, bool encodeSrgb) {
+    if (!isConversionSupported(from.format, to.format, encodeSrgb)) {
+        throw std::runtime_error("Unsupported pixel format conversion");
+    }
+
+    int width = std::min(from.width, to.width);
+    int height = std::min(from.height, to.height);
+    if (width <= 0 || height <= 0) return;
+
+    auto in = static_cast<const std::uint8_t*>(from.data);
+    auto out = static_cast<std::uint8_t*>(to.data);
+
+    // Byte orders with 8 bits per channel convert with a single permutation
+    // Permutations pick source bytes, so the source order is inverted to get
+    // the byte holding each RGBA channel
+    std::uint8_t fromOrder[4];
+    std::uint8_t toOrder[4];
+    std::uint8_t fromRgba[4];
+    getByteOrder(from.format, fromOrder);
+    getByteOrder(to.format, toOrder);
+    for (int j = 0; j < 4; j++) fromRgba[fromOrder[j]] = static_cast<std::uint8_t>(j);
+    if (from.format == to.format || (isBytePermutation(from.format) && isBytePermutation(to.format))) {
+        if (!encodeSrgb && from.format == to.format) {
+            std::size_t rowSize = std::size_t(width) * getBytesPerPixel(to.format);
+            for (int y = 0; y < height; y++) std::memcpy(out + y * to.stride, in + y * from.stride, rowSize);
+            return;
+        }
+
+        if (!encodeSrgb && isBytePermutation(from.format)) {
+            std::uint8_t order[4];
+            for (int j = 0; j < 4; j++) order[j] = fromRgba[toOrder[j]];
+            for (int y = 0; y < height; y++) permute(in + y * from.stride, out + y * to.stride, width, order);
+            return;
+        }
+    }
+
+    // Anything else goes through a row of 8 bit RGBA
+    std::vector<std::uint8_t> rgbaRow(std::size_t(width) * 4);
+    const std::uint8_t rgbaOrder[4] = { 0, 1, 2, 3 };
+    std::uint8_t packOrder[4];
+    for (int j = 0; j < 4; j++) packOrder[j] = rgbaOrder[toOrder[j]];
+    bool sourceRgba8 = from.format == PixelFormat::Rgba8888;
+
+    for (int y = 0; y < height; y++) {
+        const std::uint8_t* rowIn = in + y * from.stride;
+        std::uint8_t* rowOut = out + y * to.stride;
+
+        const std::uint8_t* rgba = rowIn;
+        if (from.format == PixelFormat::Rgba16f) {
+            halfToRgba8(reinterpret_cast<const std::uint16_t*>(rowIn), rgbaRow.data(), width, encodeSrgb);
+            rgba = rgbaRow.data();
+        } else if (!sourceRgba8 || encodeSrgb) {
+            if (sourceRgba8) std::memcpy(rgbaRow.data(), rowIn, rgbaRow.size());
+            else permute(rowIn, rgbaRow.data(), width, fromRgba);
+
+            if (encodeSrgb) {
+                const std::uint8_t* srgbTable = getSrgbTable8();
+                for (std::size_t i = 0; i < rgbaRow.size(); i += 4) {
+                    rgbaRow[i] = srgbTable[rgbaRow[i]];
+                    rgbaRow[i + 1] = srgbTable[rgbaRow[i + 1]];
+                    rgbaRow[i + 2] = srgbTable[rgbaRow[i + 2]];
+                }
+            }
+            rgba = rgbaRow.data();
+        }
+
+        if (to.format == PixelFormat::Rgb565) pack565(rgba, reinterpret_cast<std::uint16_t*>(rowOut), width);
+        else if (to.format == PixelFormat::Xrgb2101010) pack2101010(rgba, reinterpret_cast<std::uint32_t*>(rowOut), width);
+        else permute(rgba, rowOut, width, packOrder);
+    }
+}
+
+void esd::wnd::Window::presentPixels(const PixelBuffer& pixels, bool encodeSrgb) {
+    convertPixels(pixels, getPixelBuffer(), encodeSrgb);
+    presentPixelBuffer();
+}
+
+Rect esd::wnd::getScaledRect(int width, int height, int targetWidth, int targetHeight, ScaleMode mode) {
+    if (width <= 0 || height <= 0 || targetWidth <= 0 || targetHeight <= 0) return { 0, 0, 0, 0 };
+
+    int scaledWidth, scaledHeight;
+    int factor = std::min(targetWidth / width, targetHeight / height);
+    if (mode == ScaleMode::Integer && factor >= 1) {
+        scaledWidth = width * factor;
+        scaledHeight = height * factor;
+    } else if (std::int64_t(targetWidth) * height <= std::int64_t(targetHeight) * width) {
+        scaledWidth = targetWidth;
+        scaledHeight = static_cast<int>(std::int64_t(height) * targetWidth / width);
+    } else {
+        scaledWidth = static_cast<int>(std::int64_t(width) * targetHeight / height);
+        scaledHeight = targetHeight;
+    }
+
+    return { (targetWidth - scaledWidth) / 2, (targetHeight - scaledHeight) / 2, scaledWidth, scaledHeight };
+}
+
+void esd::wnd::scalePixels(const PixelBuffer& from, const PixelBuffer& to, ScaleMode mode) {
+    if (!isConversionSupported(from.format, to.format)) {
+        throw std::runtime_error("Unsupported pixel format conversion");
+    }
+
+    Rect rect = getScaledRect(from.width, from.height, to.width, to.height, mode);
+    std::size_t pixelSize = getBytesPerPixel(to.format);
+    auto out = static_cast<std::uint8_t*>(to.data);
+
+    // Bars around the image, black in every format windows present
+    for (int y = 0; y < to.height; y++) {
+        std::uint8_t* row = out + y * to.stride;
+        if (y < rect.y || y >= rect.y + rect.h) {
+            std::memset(row, 0, to.width * pixelSize);
+        } else {
+            std::memset(row, 0, rect.x * pixelSize);
+            std::memset(row + (rect.x + rect.w) * pixelSize, 0, (to.width - rect.x - rect.w) * pixelSize);
+        }
+    }
+    if (rect.w <= 0 || rect.h <= 0) return;
+
+    // Each source row is converted once, then scaled into the first target
+    // row it covers and copied to the rest
+    std::vector<std::uint8_t> convertedRow(from.width * pixelSize);
+    PixelBuffer converted = { convertedRow.data(), convertedRow.size(), from.width, 1, to.format };
+
+    int factor = rect.w % from.width == 0 ? rect.w / from.width : 0;
+    bool vectorFactor = factor > 0 && (pixelSize == 4 || pixelSize == 2);
+    std::vector<int> columns;
+    if (!vectorFactor) {
+        columns.resize(rect.w);
+        for (int x = 0; x < rect.w; x++) columns[x] = static_cast<int>(std::int64_t(x) * from.width / rect.w);
+    }
+
+    int lastSourceY = -1;
+    for (int y = 0; y < rect.h; y++) {
+        std::uint8_t* row = out + (rect.y + y) * to.stride + rect.x * pixelSize;
+        int sourceY = static_cast<int>(std::int64_t(y) * from.height / rect.h);
+        if (sourceY == lastSourceY) {
+            std::memcpy(row, row - to.stride, rect.w * pixelSize);
+            continue;
+        }
+        lastSourceY = sourceY;
+
+        PixelBuffer sourceRow = from;
+        sourceRow.data = static_cast<std::uint8_t*>(from.data) + sourceY * from.stride;
+        sourceRow.height = 1;
+        convertPixels(sourceRow, converted);
+
+        if (vectorFactor && pixelSize == 4) {
+            replicate32(reinterpret_cast<const std::uint32_t*>(convertedRow.data()), reinterpret_cast<std::uint32_t*>(row), from.width, factor);
+        } else if (vectorFactor) {
+            replicate16(reinterpret_cast<const std::uint16_t*>(convertedRow.data()), reinterpret_cast<std::uint16_t*>(row), from.width, factor);
+        } else if (pixelSize == 4) {
+            sampleRow(reinterpret_cast<const std::uint32_t*>(convertedRow.data()), reinterpret_cast<std::uint32_t*>(row), columns);
+        } else if (pixelSize == 2) {
+            sampleRow(reinterpret_cast<const std::uint16_t*>(convertedRow.data()), reinterpret_cast<std::uint16_t*>(row), columns);
+        } else {
+            sampleRow(reinterpret_cast<const std::uint64_t*>(convertedRow.data()), reinterpret_cast<std::uint64_t*>(row), columns);
+        }
+    }
+}
+
+void esd::wnd::Window::presentPixelsScaled(const PixelBuffer& pixels, ScaleMode mode) {
+    scalePixels(pixels, getPixelBuffer(), mode);
+    presentPixelBuffer();
+}
@@ -0,0 +1,99 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#include "simd.hpp"
+#include <atomic>
+#include <cstring>
+
+using namespace esd::wnd;
+
+namespace {
+
+Isa detectIsa() {
+#if defined(ESD_WND_SIMD_NEON)
+    return Isa::Neon;
+#else
+#if defined(ESD_WND_SIMD_AVX2)
+    // AVX2 and F16C, with the OS saving YMM registers
+    unsigned int leaf1[4] = {};
+    unsigned int leaf7[4] = {};
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    std::memcpy(leaf1, info, sizeof(leaf1));
+    if (maxLeaf >= 7) {
+        __cpuidex(info, 7, 0);
+        std::memcpy(leaf7, info, sizeof(leaf7));
+    }
+#else
+    unsigned int maxLeaf = __get_cpuid_max(0, nullptr);
+    __get_cpuid(1, &leaf1[0], &leaf1[1], &leaf1[2], &leaf1[3]);
+    if (maxLeaf >= 7) __cpuid_count(7, 0, leaf7[0], leaf7[1], leaf7[2], leaf7[3]);
+#endif
+
+    bool osxsave = leaf1[2] >> 27 & 1;
+    bool avx = leaf1[2] >> 28 & 1;
+    bool f16c = leaf1[2] >> 29 & 1;
+    bool avx2 = leaf7[1] >> 5 & 1;
+    if (osxsave && avx && f16c && avx2) {
+#if defined(_MSC_VER)
+        unsigned long long xcr0 = _xgetbv(0);
+#else
+        unsigned int xcr0Low, xcr0High;
+        __asm__("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+        unsigned long long xcr0 = xcr0Low;
+#endif
+        if ((xcr0 & 0x6) == 0x6) return Isa::Avx2;
+    }
+#endif
+
+#if defined(ESD_WND_SIMD_SSE2)
+    return Isa::Sse2;
+#else
+    return Isa::Scalar;
+#endif
+#endif
+}
+
+Isa getDetectedIsa() {
+    static const Isa isa = detectIsa();
+    return isa;
+}
+
+std::atomic<Isa>& getSelectedIsa() {
+    static std::atomic<Isa> isa(getDetectedIsa());
+    return isa;
+}
+
+}
+
+Isa esd::wnd::getIsa() {
+    return getSelectedIsa().load(std::memory_order_relaxed);
+}
+
+bool esd::wnd::setIsa(Isa isa) {
+    // AVX2 machines also run SSE2 kernels
+    Isa detected = getDetectedIsa();
+    bool supported = isa == Isa::Scalar || isa == detected || (isa == Isa::Sse2 && detected == Isa::Avx2);
+    if (supported) getSelectedIsa().store(isa, std::memory_order_relaxed);
+    return supported;
+}
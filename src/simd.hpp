@@ -0,0 +1,64 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ESD_WND_SIMD_X86
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ESD_WND_SIMD_SSE2
+#endif
+#if defined(__GNUC__) || defined(_MSC_VER)
+#define ESD_WND_SIMD_AVX2
+#endif
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#elif defined(__ARM_NEON)
+#define ESD_WND_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+// AVX2 kernels are compiled for AVX2 regardless of the target, and only called
+// when the CPU supports it
+#if defined(ESD_WND_SIMD_AVX2) && defined(__GNUC__)
+#define ESD_WND_TARGET_AVX2 __attribute__((target("avx2,f16c")))
+#else
+#define ESD_WND_TARGET_AVX2
+#endif
+
+namespace esd::wnd {
+
+// Instruction set used by pixel kernels, where AVX2 also implies F16C
+enum struct Isa { Scalar, Sse2, Avx2, Neon };
+
+// Instruction set kernels use, by default the best one supported by both the
+// build and the CPU, detected on first use
+Isa getIsa();
+
+// Use another supported instruction set, e.g. to benchmark or test the
+// fallbacks
+// Returns false and changes nothing if the build or the CPU doesn't support it
+bool setIsa(Isa isa);
+
+}
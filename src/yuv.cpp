@@ -0,0 +1,303 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#include "simd.hpp"
+#include <eseed/window/pixels.hpp>
+#include <eseed/window/window.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+using namespace esd::wnd;
+
+namespace {
+
+// Conversion factors giving channels in 10.6 fixed point, so every
+// intermediate fits in 16 bits for the vector kernels (sums past the 16 bit
+// range saturate, which can only happen for values that clamp anyway)
+// Luma is scaled as Y * 257 (Y in both bytes) times yScale / 65536, which is
+// more precise than a 6 bit factor, and then yBias is subtracted, covering the
+// limited range offset and rounding
+struct Coefficients {
+    std::uint16_t yScale;
+    std::int16_t yBias;
+    std::int16_t rCr, gCb, gCr, bCb;
+};
+
+Coefficients getCoefficients(YuvMatrix matrix, YuvRange range) {
+    double kr = matrix == YuvMatrix::Bt709 ? 0.2126 : 0.299;
+    double kb = matrix == YuvMatrix::Bt709 ? 0.0722 : 0.114;
+    double kg = 1.0 - kr - kb;
+    bool limited = range == YuvRange::Limited;
+    double yScale = limited ? 255.0 / 219.0 : 1.0;
+    double cScale = limited ? 255.0 / 224.0 : 1.0;
+
+    auto fixed = [](double value) { return static_cast<std::int16_t>(std::lround(value * 64.0)); };
+    Coefficients coefficients;
+    coefficients.yScale = static_cast<std::uint16_t>(std::lround(yScale * 64.0 * 65536.0 / 257.0));
+    coefficients.yBias = static_cast<std::int16_t>(std::lround((limited ? 16.0 : 0.0) * yScale * 64.0) - 32);
+    coefficients.rCr = fixed(2.0 * (1.0 - kr) * cScale);
+    coefficients.gCb = fixed(2.0 * kb * (1.0 - kb) / kg * cScale);
+    coefficients.gCr = fixed(2.0 * kr * (1.0 - kr) / kg * cScale);
+    coefficients.bCb = fixed(2.0 * (1.0 - kb) * cScale);
+    return coefficients;
+}
+
+// Row kernels convert count pixels starting at x, writing R, G, B and opaque
+// alpha in the given byte order (output byte i is channel order[i])
+// Chroma samples are chromaStep bytes apart, 1 for I420 and 2 for NV12 where
+// v is u + 1
+struct YuvRow {
+    const std::uint8_t* y;
+    const std::uint8_t* u;
+    const std::uint8_t* v;
+    int chromaStep;
+};
+
+void convertRowScalar(const YuvRow& row, std::uint8_t* out, int x, int count, const std::uint8_t order[4], const Coefficients& k) {
+    auto clamp = [](int value) { return static_cast<std::uint8_t>(std::clamp(value >> 6, 0, 255)); };
+    for (int end = x + count; x < end; x++) {
+        int luma = static_cast<int>(row.y[x] * 257u * k.yScale >> 16) - k.yBias;
+        int cb = row.u[x / 2 * row.chromaStep] - 128;
+        int cr = row.v[x / 2 * row.chromaStep] - 128;
+
+        std::uint8_t channels[4] = {
+            clamp(luma + k.rCr * cr),
+            clamp(luma - k.gCb * cb - k.gCr * cr),
+            clamp(luma + k.bCb * cb),
+            255
+        };
+        for (int i = 0; i < 4; i++) out[x * 4 + i] = channels[order[i]];
+    }
+}
+
+#if defined(ESD_WND_SIMD_SSE2)
+
+void convertRowSse2(const YuvRow& row, std::uint8_t* out, int width, const std::uint8_t order[4], const Coefficients& k) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i yScale = _mm_set1_epi16(static_cast<short>(k.yScale));
+    const __m128i yBias = _mm_set1_epi16(k.yBias);
+    const __m128i chromaOffset = _mm_set1_epi16(128);
+    const __m128i rCr = _mm_set1_epi16(k.rCr);
+    const __m128i gCb = _mm_set1_epi16(k.gCb);
+    const __m128i gCr = _mm_set1_epi16(k.gCr);
+    const __m128i bCb = _mm_set1_epi16(k.bCb);
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m128i luma = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row.y + x));
+        __m128i lumaLow = _mm_sub_epi16(_mm_mulhi_epu16(_mm_unpacklo_epi8(luma, luma), yScale), yBias);
+        __m128i lumaHigh = _mm_sub_epi16(_mm_mulhi_epu16(_mm_unpackhi_epi8(luma, luma), yScale), yBias);
+
+        // Eight chroma samples, each shared by two pixels
+        __m128i cb, cr;
+        if (row.chromaStep == 2) {
+            __m128i uv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row.u + x));
+            cb = _mm_and_si128(uv, _mm_set1_epi16(0xFF));
+            cr = _mm_srli_epi16(uv, 8);
+        } else {
+            cb = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row.u + x / 2)), zero);
+            cr = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row.v + x / 2)), zero);
+        }
+        cb = _mm_sub_epi16(cb, chromaOffset);
+        cr = _mm_sub_epi16(cr, chromaOffset);
+
+        __m128i r = _mm_mullo_epi16(cr, rCr);
+        __m128i g = _mm_add_epi16(_mm_mullo_epi16(cb, gCb), _mm_mullo_epi16(cr, gCr));
+        __m128i b = _mm_mullo_epi16(cb, bCb);
+
+        __m128i channels[4];
+        channels[0] = _mm_packus_epi16(
+            _mm_srai_epi16(_mm_adds_epi16(lumaLow, _mm_unpacklo_epi16(r, r)), 6),
+            _mm_srai_epi16(_mm_adds_epi16(lumaHigh, _mm_unpackhi_epi16(r, r)), 6)
+        );
+        channels[1] = _mm_packus_epi16(
+            _mm_srai_epi16(_mm_subs_epi16(lumaLow, _mm_unpacklo_epi16(g, g)), 6),
+            _mm_srai_epi16(_mm_subs_epi16(lumaHigh, _mm_unpackhi_epi16(g, g)), 6)
+        );
+        channels[2] = _mm_packus_epi16(
+            _mm_srai_epi16(_mm_adds_epi16(lumaLow, _mm_unpacklo_epi16(b, b)), 6),
+            _mm_srai_epi16(_mm_adds_epi16(lumaHigh, _mm_unpackhi_epi16(b, b)), 6)
+        );
+        channels[3] = _mm_set1_epi8(-1);
+
+        // Interleave the channels into pixels
+        __m128i low01 = _mm_unpacklo_epi8(channels[order[0]], channels[order[1]]);
+        __m128i high01 = _mm_unpackhi_epi8(channels[order[0]], channels[order[1]]);
+        __m128i low23 = _mm_unpacklo_epi8(channels[order[2]], channels[order[3]]);
+        __m128i high23 = _mm_unpackhi_epi8(channels[order[2]], channels[order[3]]);
+        __m128i* pixels = reinterpret_cast<__m128i*>(out + x * 4);
+        _mm_storeu_si128(pixels, _mm_unpacklo_epi16(low01, low23));
+        _mm_storeu_si128(pixels + 1, _mm_unpackhi_epi16(low01, low23));
+        _mm_storeu_si128(pixels + 2, _mm_unpacklo_epi16(high01, high23));
+        _mm_storeu_si128(pixels + 3, _mm_unpackhi_epi16(high01, high23));
+    }
+    convertRowScalar(row, out, x, width - x, order, k);
+}
+
+#endif
+
+#if defined(ESD_WND_SIMD_NEON)
+
+void convertRowNeon(const YuvRow& row, std::uint8_t* out, int width, const std::uint8_t order[4], const Coefficients& k) {
+    const int16x8_t yBias = vdupq_n_s16(k.yBias);
+    const int16x8_t chromaOffset = vdupq_n_s16(128);
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        uint8x16_t luma = vld1q_u8(row.y + x);
+        auto scaleLuma = [&](uint8x8_t luma) {
+            uint16x8_t luma16 = vreinterpretq_u16_u8(vcombine_u8(vzip_u8(luma, luma).val[0], vzip_u8(luma, luma).val[1]));
+            uint16x4_t low = vshrn_n_u32(vmull_n_u16(vget_low_u16(luma16), k.yScale), 16);
+            uint16x4_t high = vshrn_n_u32(vmull_n_u16(vget_high_u16(luma16), k.yScale), 16);
+            return vsubq_s16(vreinterpretq_s16_u16(vcombine_u16(low, high)), yBias);
+        };
+        int16x8_t lumaLow = scaleLuma(vget_low_u8(luma));
+        int16x8_t lumaHigh = scaleLuma(vget_high_u8(luma));
+
+        // Eight chroma samples, each shared by two pixels
+        uint8x8_t u, v;
+        if (row.chromaStep == 2) {
+            uint8x8x2_t uv = vld2_u8(row.u + x);
+            u = uv.val[0];
+            v = uv.val[1];
+        } else {
+            u = vld1_u8(row.u + x / 2);
+            v = vld1_u8(row.v + x / 2);
+        }
+        int16x8_t cb = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(u)), chromaOffset);
+        int16x8_t cr = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(v)), chromaOffset);
+
+        int16x8x2_t r = vzipq_s16(vmulq_n_s16(cr, k.rCr), vmulq_n_s16(cr, k.rCr));
+        int16x8_t gSingle = vaddq_s16(vmulq_n_s16(cb, k.gCb), vmulq_n_s16(cr, k.gCr));
+        int16x8x2_t g = vzipq_s16(gSingle, gSingle);
+        int16x8x2_t b = vzipq_s16(vmulq_n_s16(cb, k.bCb), vmulq_n_s16(cb, k.bCb));
+
+        uint8x16_t channels[4];
+        channels[0] = vcombine_u8(
+            vqmovun_s16(vshrq_n_s16(vqaddq_s16(lumaLow, r.val[0]), 6)),
+            vqmovun_s16(vshrq_n_s16(vqaddq_s16(lumaHigh, r.val[1]), 6))
+        );
+        channels[1] = vcombine_u8(
+            vqmovun_s16(vshrq_n_s16(vqsubq_s16(lumaLow, g.val[0]), 6)),
+            vqmovun_s16(vshrq_n_s16(vqsubq_s16(lumaHigh, g.val[1]), 6))
+        );
+        channels[2] = vcombine_u8(
+            vqmovun_s16(vshrq_n_s16(vqaddq_s16(lumaLow, b.val[0]), 6)),
+            vqmovun_s16(vshrq_n_s16(vqaddq_s16(lumaHigh, b.val[1]), 6))
+        );
+        channels[3] = vdupq_n_u8(255);
+
+        uint8x16x4_t pixels;
+        for (int i = 0; i < 4; i++) pixels.val[i] = channels[order[i]];
+        vst4q_u8(out + x * 4, pixels);
+    }
+    convertRowScalar(row, out, x, width - x, order, k);
+}
+
+#endif
+
+void convertRow(const YuvRow& row, std::uint8_t* out, int width, const std::uint8_t order[4], const Coefficients& k) {
+    Isa isa = getIsa();
+#if defined(ESD_WND_SIMD_SSE2)
+    if (isa != Isa::Scalar) return convertRowSse2(row, out, width, order, k);
+#endif
+#if defined(ESD_WND_SIMD_NEON)
+    if (isa == Isa::Neon) return convertRowNeon(row, out, width, order, k);
+#endif
+    convertRowScalar(row, out, 0, width, order, k);
+}
+
+}
+
+void esd::wnd::convertYuv(const YuvFrame& from, const PixelBuffer& to) {
+    // Byte orders write pixels straight into the buffer, packed formats go
+    // through a row of RGBA small enough to stay in cache
+    std::uint8_t order[4] = { 0, 1, 2, 3 };
+    bool direct = true;
+    switch (to.format) {
+    case PixelFormat::Rgba8888:
+    case PixelFormat::Rgbx8888:
+        break;
+    case PixelFormat::Bgra8888:
+    case PixelFormat::Bgrx8888:
+        order[0] = 2;
+        order[2] = 0;
+        break;
+    case PixelFormat::Xrgb8888:
+        order[0] = 3;
+        order[1] = 0;
+        order[2] = 1;
+        order[3] = 2;
+        break;
+    case PixelFormat::Xbgr8888:
+        order[0] = 3;
+        order[1] = 2;
+        order[2] = 1;
+        order[3] = 0;
+        break;
+    case PixelFormat::Rgb565:
+    case PixelFormat::Xrgb2101010:
+        direct = false;
+        break;
+    default:
+        throw std::runtime_error("Unsupported pixel format for video frames");
+    }
+
+    int width = std::min(from.width, to.width);
+    int height = std::min(from.height, to.height);
+    if (width <= 0 || height <= 0) return;
+
+    Coefficients coefficients = getCoefficients(from.matrix, from.range);
+    std::vector<std::uint8_t> rgbaRow(direct ? 0 : std::size_t(width) * 4);
+    PixelBuffer rgba = { rgbaRow.data(), rgbaRow.size(), width, 1, PixelFormat::Rgba8888 };
+
+    auto planes = reinterpret_cast<const std::uint8_t* const*>(from.planes);
+    for (int y = 0; y < height; y++) {
+        YuvRow row;
+        row.y = planes[0] + y * from.strides[0];
+        row.u = planes[1] + y / 2 * from.strides[1];
+        if (from.format == YuvFormat::Nv12) {
+            row.v = row.u + 1;
+            row.chromaStep = 2;
+        } else {
+            row.v = planes[2] + y / 2 * from.strides[2];
+            row.chromaStep = 1;
+        }
+
+        std::uint8_t* rowOut = static_cast<std::uint8_t*>(to.data) + y * to.stride;
+        if (direct) {
+            convertRow(row, rowOut, width, order, coefficients);
+        } else {
+            convertRow(row, rgbaRow.data(), width, order, coefficients);
+            PixelBuffer target = to;
+            target.data = rowOut;
+            target.height = 1;
+            convertPixels(rgba, target);
+        }
+    }
+}
+
+void esd::wnd::Window::presentYuv(const YuvFrame& frame) {
+    convertYuv(frame, getPixelBuffer());
+    presentPixelBuffer();
+}
@@ -0,0 +1,55 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+
+namespace esd::wnd::test {
+
+// Exit code that marks a test as skipped, e.g. without an X server
+constexpr int skipped = 77;
+
+inline int failures = 0;
+
+inline void check(bool passed, const char* expression, const char* file, int line) {
+    if (passed) return;
+    std::cerr << file << ":" << line << ": check failed: " << expression << std::endl;
+    failures++;
+}
+
+template <typename A, typename B>
+void checkEqual(const A& a, const B& b, const char* expression, const char* file, int line) {
+    if (a == b) return;
+    std::cerr << file << ":" << line << ": check failed: " << expression 
+        << " (" << +a << " != " << +b << ")" << std::endl;
+    failures++;
+}
+
+inline int result() {
+    if (failures > 0) std::cerr << failures << " check(s) failed" << std::endl;
+    return failures > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+}
+
+#define ESD_CHECK(expression) esd::wnd::test::check((expression), #expression, __FILE__, __LINE__)
+#define ESD_CHECK_EQ(a, b) esd::wnd::test::checkEqual((a), (b), #a " == " #b, __FILE__, __LINE__)
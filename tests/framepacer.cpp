@@ -0,0 +1,92 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#include "check.hpp"
+#include <eseed/window/framepacer.hpp>
+
+using namespace esd::wnd;
+using namespace std::chrono_literals;
+
+namespace {
+
+// Simulated time, where sleeps wake late and every spin takes a microsecond
+class TestClock : public PacingClock {
+public:
+    std::chrono::nanoseconds time = 1s;
+    std::chrono::nanoseconds sleepLatency = 200us;
+
+    std::chrono::nanoseconds now() override { return time; }
+    void sleep(std::chrono::nanoseconds duration) override { time += duration + sleepLatency; }
+    void spin() override { time += 1us; }
+};
+
+}
+
+int main() {
+    TestClock clock;
+    FramePacer pacer(clock);
+    pacer.setRefreshRate(144);
+
+    const std::chrono::nanoseconds period(6944444);
+    const std::chrono::nanoseconds anchor = 1s + 3ms;
+    pacer.syncVblank(anchor);
+
+    // Frames land on the vblank grid half a period early, one vblank apart
+    // while they take less than a period
+    FrameInfo last = pacer.waitForFrame();
+    ESD_CHECK_EQ((last.vblankTime - anchor).count() % period.count(), 0);
+    for (int i = 0; i < 100; i++) {
+        clock.time += 2ms;
+        FrameInfo info = pacer.waitForFrame();
+        ESD_CHECK_EQ((info.vblankTime - last.vblankTime).count(), period.count());
+        ESD_CHECK_EQ(info.missedVblanks, 0u);
+        ESD_CHECK(info.time >= info.vblankTime - period / 2);
+        ESD_CHECK(info.time < info.vblankTime - period / 2 + 2us);
+        last = info;
+    }
+
+    // Overrunning by one and a half periods skips the two vblanks that can no
+    // longer be made
+    clock.time += period * 5 / 2;
+    FrameInfo late = pacer.waitForFrame();
+    ESD_CHECK_EQ(late.missedVblanks, 2u);
+    ESD_CHECK_EQ((late.vblankTime - last.vblankTime).count(), 3 * period.count());
+
+    // A measured vblank moves the grid, without targeting a vblank twice
+    const std::chrono::nanoseconds moved = late.vblankTime + period / 3;
+    pacer.syncVblank(moved);
+    FrameInfo synced = pacer.waitForFrame();
+    ESD_CHECK_EQ((synced.vblankTime - moved).count() % period.count(), 0);
+    ESD_CHECK(synced.vblankTime > late.vblankTime);
+
+    // A gap after restarting isn't a long frame or missed vblanks
+    clock.time += 1s;
+    pacer.restart();
+    FrameInfo restarted = pacer.waitForFrame();
+    ESD_CHECK_EQ(restarted.deltaTime, 0.0);
+    ESD_CHECK_EQ(restarted.missedVblanks, 0u);
+
+    FramePacingStats stats = pacer.getStats();
+    ESD_CHECK_EQ(stats.frames, 104u);
+    ESD_CHECK_EQ(stats.missedVblanks, 2u);
+    ESD_CHECK(stats.maxWakeError < 2e-6);
+
+    return esd::wnd::test::result();
+}
@@ -0,0 +1,60 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#include "check.hpp"
+#include <eseed/window/gamepad.hpp>
+#include <linux/input.h>
+
+using namespace esd::wnd;
+
+// gamepadreplay.bin holds three reports from a 64-bit machine:
+//  1. South pressed, left stick fully right
+//  2. South released, left stick fully left, left trigger fully pressed
+//  3. Start pressed
+int main() {
+    if (sizeof(input_event) != 24) return esd::wnd::test::skipped;
+
+    Gamepads gamepads;
+    int id = gamepads.open(ESD_WND_TEST_DATA_DIR "/gamepadreplay.bin");
+
+    gamepads.poll();
+    const GamepadState& state = gamepads.getState(id);
+    ESD_CHECK(state.isButtonDown(GamepadButton::South));
+    ESD_CHECK_EQ(state.getAxis(GamepadAxis::LeftX), 1.0f);
+    ESD_CHECK_EQ(state.getAxis(GamepadAxis::LeftTrigger), 0.0f);
+
+    gamepads.poll();
+    ESD_CHECK(!state.isButtonDown(GamepadButton::South));
+    ESD_CHECK_EQ(state.getAxis(GamepadAxis::LeftX), -1.0f);
+    ESD_CHECK_EQ(state.getAxis(GamepadAxis::LeftTrigger), 1.0f);
+    ESD_CHECK(!state.isButtonDown(GamepadButton::Start));
+
+    gamepads.poll();
+    ESD_CHECK(state.isButtonDown(GamepadButton::Start));
+    ESD_CHECK_EQ(state.getAxis(GamepadAxis::LeftX), -1.0f);
+
+    // The end of a recording keeps its last state
+    gamepads.poll();
+    ESD_CHECK(gamepads.isConnected(id));
+    ESD_CHECK(state.isButtonDown(GamepadButton::Start));
+    ESD_CHECK_EQ(state.getAxis(GamepadAxis::LeftTrigger), 1.0f);
+
+    return esd::wnd::test::result();
+}
@@ -0,0 +1,123 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#include "check.hpp"
+#include "keytable.hpp"
+#include <X11/keysym.h>
+
+using namespace esd::wnd;
+
+namespace {
+
+// A table with one key type and one single group key per entry, laid out the
+// way KeyTable::build() lays out the XKB map
+struct TestKey { unsigned int type; std::initializer_list<KeySym> levels; std::initializer_list<KeySym> upper; };
+
+KeyTable makeTable(std::initializer_list<TestKey> keys) {
+    KeyTable table;
+
+    // ONE_LEVEL, TWO_LEVEL and ALPHABETIC as defined by XKB
+    table.keyTypes = {
+        { 0, {} },
+        { ShiftMask, { { ShiftMask, 1 } } },
+        { ShiftMask | LockMask, { { ShiftMask, 1 }, { LockMask, 1 } } },
+    };
+
+    table.keyChars.resize(8);
+    for (const auto& testKey : keys) {
+        KeyTable::KeyChars key = {};
+        key.groupCount = 1;
+        key.width = static_cast<std::uint8_t>(testKey.levels.size());
+        key.types[0] = static_cast<std::uint8_t>(testKey.type);
+        key.offset = table.chars.size();
+        for (KeySym keySym : testKey.levels) table.chars.push_back(KeyTable::keySymToCodePoint(keySym));
+        for (KeySym keySym : testKey.upper) table.upperChars.push_back(KeyTable::keySymToCodePoint(keySym));
+        table.keyChars.push_back(key);
+    }
+
+    return table;
+}
+
+void testLegacyKeySyms() {
+    ESD_CHECK_EQ(KeyTable::keySymToCodePoint(XK_a), U'a');
+    ESD_CHECK_EQ(KeyTable::keySymToCodePoint(XK_eacute), U'é');
+    ESD_CHECK_EQ(KeyTable::keySymToCodePoint(0x01000000 + 0x1F600), U'\U0001F600');
+
+    // Latin-2, Latin-4 and Latin-9
+    ESD_CHECK_EQ(KeyTable::keySymToCodePoint(XK_aogonek), U'ą');
+    ESD_CHECK_EQ(KeyTable::keySymToCodePoint(XK_Lstroke), U'Ł');
+    ESD_CHECK_EQ(KeyTable::keySymToCodePoint(0x3e0), U'ā'); // amacron
+    ESD_CHECK_EQ(KeyTable::keySymToCodePoint(0x13bd), U'œ'); // oe
+
+    // Cyrillic, Greek, Arabic, Hebrew and Thai
+    ESD_CHECK_EQ(KeyTable::keySymToCodePoint(0x6c1), U'а'); // Cyrillic_a
+    ESD_CHECK_EQ(KeyTable::keySymToCodePoint(0x6e1), U'А'); // Cyrillic_A
+    ESD_CHECK_EQ(KeyTable::keySymToCodePoint(0x7e1), U'α'); // Greek_alpha
+    ESD_CHECK_EQ(KeyTable::keySymToCodePoint(0x5c7), U'ا'); // Arabic_alef
+    ESD_CHECK_EQ(KeyTable::keySymToCodePoint(0xce0), U'א'); // hebrew_aleph
+    ESD_CHECK_EQ(KeyTable::keySymToCodePoint(0xda1), U'ก'); // Thai_kokai
+
+    ESD_CHECK_EQ(KeyTable::keySymToCodePoint(0x20ac), U'€'); // EuroSign
+
+    // Legacy keysyms without a Unicode equivalent, and dead keys
+    ESD_CHECK_EQ(KeyTable::keySymToCodePoint(0x100), KeyTable::inputMethodOnly);
+    ESD_CHECK_EQ(KeyTable::keySymToCodePoint(XK_dead_acute), KeyTable::inputMethodOnly);
+
+    // Keys that type nothing
+    ESD_CHECK_EQ(KeyTable::keySymToCodePoint(XK_Shift_L), U'\0');
+    ESD_CHECK_EQ(KeyTable::keySymToCodePoint(NoSymbol), U'\0');
+}
+
+void testCase() {
+    KeyTable table = makeTable({
+        { 2, { 0x6c1, 0x6e1 }, { 0x6e1, 0x6e1 } }, // Cyrillic_a, ALPHABETIC
+        { 1, { 0x7e1, 0x7c1 }, { 0x7c1, 0x7c1 } }, // Greek_alpha, TWO_LEVEL
+        { 1, { XK_1, XK_exclam }, { XK_1, XK_exclam } },
+        { 0, { XK_x }, { XK_X } },
+    });
+
+    // ALPHABETIC uses Lock for its shift level, so Shift + Lock is lower case
+    ESD_CHECK_EQ(table.translateKey(8, 0), U'а');
+    ESD_CHECK_EQ(table.translateKey(8, ShiftMask), U'А');
+    ESD_CHECK_EQ(table.translateKey(8, LockMask), U'А');
+    ESD_CHECK_EQ(table.translateKey(8, ShiftMask | LockMask), U'а');
+
+    // TWO_LEVEL ignores Lock, which then upper cases the character
+    ESD_CHECK_EQ(table.translateKey(9, 0), U'α');
+    ESD_CHECK_EQ(table.translateKey(9, LockMask), U'Α');
+    ESD_CHECK_EQ(table.translateKey(9, ShiftMask | LockMask), U'Α');
+
+    // Characters without case are left alone
+    ESD_CHECK_EQ(table.translateKey(10, LockMask), U'1');
+    ESD_CHECK_EQ(table.translateKey(10, ShiftMask | LockMask), U'!');
+
+    // Shift upper cases keys with a single level
+    ESD_CHECK_EQ(table.translateKey(11, 0), U'x');
+    ESD_CHECK_EQ(table.translateKey(11, ShiftMask), U'X');
+    ESD_CHECK_EQ(table.translateKey(11, ControlMask), U'\x18');
+}
+
+}
+
+int main() {
+    testLegacyKeySyms();
+    testCase();
+    return test::result();
+}
@@ -0,0 +1,132 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#include "check.hpp"
+#include "simd.hpp"
+#include <eseed/window/pixels.hpp>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+using namespace esd::wnd;
+
+namespace {
+
+// Odd width, so rows have both vector and scalar tails
+constexpr int width = 37;
+
+struct ByteFormat { PixelFormat format; int r, g, b, a; };
+
+// Byte holding each channel, by the names in pixels.hpp
+constexpr ByteFormat byteFormats[] = {
+    { PixelFormat::Bgrx8888, 2, 1, 0, 3 },
+    { PixelFormat::Rgbx8888, 0, 1, 2, 3 },
+    { PixelFormat::Xrgb8888, 1, 2, 3, 0 },
+    { PixelFormat::Xbgr8888, 3, 2, 1, 0 },
+    { PixelFormat::Rgba8888, 0, 1, 2, 3 },
+    { PixelFormat::Bgra8888, 2, 1, 0, 3 }
+};
+
+std::uint8_t red(int x) { return static_cast<std::uint8_t>(x * 7); }
+std::uint8_t green(int x) { return static_cast<std::uint8_t>(255 - x * 3); }
+std::uint8_t blue(int x) { return static_cast<std::uint8_t>(x * 11 + 5); }
+
+std::uint8_t toSrgb(std::uint8_t linear) {
+    float value = linear / 255.0f;
+    value = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    return static_cast<std::uint8_t>(std::lround(value * 255.0f));
+}
+
+std::vector<std::uint8_t> makeRow(const ByteFormat& format) {
+    std::vector<std::uint8_t> row(width * 4);
+    for (int x = 0; x < width; x++) {
+        row[x * 4 + format.r] = red(x);
+        row[x * 4 + format.g] = green(x);
+        row[x * 4 + format.b] = blue(x);
+        row[x * 4 + format.a] = 0xFF;
+    }
+    return row;
+}
+
+void checkRow(const ByteFormat& format, const std::vector<std::uint8_t>& row, bool srgb) {
+    auto encode = [&](std::uint8_t c) { return srgb ? toSrgb(c) : c; };
+    for (int x = 0; x < width; x++) {
+        ESD_CHECK_EQ(row[x * 4 + format.r], encode(red(x)));
+        ESD_CHECK_EQ(row[x * 4 + format.g], encode(green(x)));
+        ESD_CHECK_EQ(row[x * 4 + format.b], encode(blue(x)));
+    }
+}
+
+PixelBuffer makeBuffer(void* data, PixelFormat format) {
+    return { data, width * getBytesPerPixel(format), width, 1, format };
+}
+
+}
+
+int main() {
+    // Every kernel the machine can run
+    for (Isa isa : { Isa::Scalar, Isa::Sse2, Isa::Avx2, Isa::Neon }) {
+        if (!setIsa(isa)) continue;
+
+        // Every 8 bit format to itself, with and without sRGB, keeps each channel
+        // in its byte
+        for (const auto& format : byteFormats) {
+            for (bool srgb : { false, true }) {
+                std::vector<std::uint8_t> in = makeRow(format);
+                std::vector<std::uint8_t> out(in.size());
+                convertPixels(makeBuffer(in.data(), format.format), makeBuffer(out.data(), format.format), srgb);
+                checkRow(format, out, srgb);
+            }
+        }
+
+        // Sources to every 8 bit window format
+        for (const auto& from : byteFormats) {
+            if (from.format != PixelFormat::Rgba8888 && from.format != PixelFormat::Bgra8888) continue;
+            for (const auto& to : byteFormats) {
+                if (to.format == PixelFormat::Rgba8888 || to.format == PixelFormat::Bgra8888) continue;
+                for (bool srgb : { false, true }) {
+                    std::vector<std::uint8_t> in = makeRow(from);
+                    std::vector<std::uint8_t> out(in.size());
+                    convertPixels(makeBuffer(in.data(), from.format), makeBuffer(out.data(), to.format), srgb);
+                    checkRow(to, out, srgb);
+                }
+            }
+        }
+    }
+
+    // Packed formats are never unpacked, so they can't be sRGB encoded in place
+    for (PixelFormat format : { PixelFormat::Rgb565, PixelFormat::Xrgb2101010, PixelFormat::Rgba16f }) {
+        ESD_CHECK(isConversionSupported(format, format));
+        ESD_CHECK(!isConversionSupported(format, format, true));
+
+        std::vector<std::uint8_t> in(width * getBytesPerPixel(format));
+        std::vector<std::uint8_t> out(in.size());
+        bool threw = false;
+        try {
+            convertPixels(makeBuffer(in.data(), format), makeBuffer(out.data(), format), true);
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        ESD_CHECK(threw);
+    }
+
+    return esd::wnd::test::result();
+}
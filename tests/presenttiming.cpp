@@ -0,0 +1,102 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#include "check.hpp"
+#include "impl.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace {
+
+class TestWindow : public esd::wnd::Window {
+public:
+    using esd::wnd::Window::Window;
+
+    bool arePixmapsIdle() {
+        for (const auto& pixmap : impl->presentPixmaps) {
+            if (!pixmap.idle) return false;
+        }
+        return true;
+    }
+};
+
+// Polls until done() holds, giving up after a couple of seconds
+template <typename F>
+bool pollUntil(TestWindow& window, F done) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        window.poll();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+}
+
+int main() {
+    if (!std::getenv("DISPLAY")) return esd::wnd::test::skipped;
+
+    TestWindow window("Present Timing", { 320, 240 });
+    if (!window.isPresentTimingSupported()) return esd::wnd::test::skipped;
+    ESD_CHECK(pollUntil(window, [&] { return window.isVisible(); }));
+
+    std::vector<esd::wnd::PresentCompleteEvent> completes;
+    window.setPresentCompleteHandler([&](esd::wnd::PresentCompleteEvent e) { completes.push_back(e); });
+    window.setPresentTimingEnabled(true);
+    ESD_CHECK(window.isPresentTimingEnabled());
+
+    // More frames than there are pixmaps, so presenting has to wait for them
+    // to go idle
+    constexpr std::uint32_t frames = 8;
+    for (std::uint32_t i = 0; i < frames; i++) {
+        esd::wnd::PixelBuffer buffer = window.getPixelBuffer();
+        std::size_t rowSize = buffer.width * esd::wnd::getBytesPerPixel(buffer.format);
+        for (int y = 0; y < buffer.height; y++) {
+            auto row = static_cast<std::uint8_t*>(buffer.data) + y * buffer.stride;
+            std::fill(row, row + rowSize, static_cast<std::uint8_t>(i * 32));
+        }
+        window.presentPixelBuffer();
+        ESD_CHECK_EQ(window.getPresentFrameNumber(), i + 1);
+    }
+
+    ESD_CHECK(pollUntil(window, [&] { return completes.size() >= frames; }));
+    ESD_CHECK_EQ(completes.size(), static_cast<std::size_t>(frames));
+
+    // Frames complete in order, each shown no earlier than the one before
+    for (std::size_t i = 0; i < completes.size(); i++) {
+        ESD_CHECK_EQ(completes[i].frame, static_cast<std::uint32_t>(i + 1));
+        if (i == 0) continue;
+        ESD_CHECK(completes[i].ust >= completes[i - 1].ust);
+        ESD_CHECK(completes[i].msc >= completes[i - 1].msc);
+    }
+    ESD_CHECK(completes.back().ust > completes.front().ust);
+    ESD_CHECK(completes.back().msc > completes.front().msc);
+
+    ESD_CHECK(pollUntil(window, [&] { return window.arePixmapsIdle(); }));
+
+    window.setPresentTimingEnabled(false);
+    ESD_CHECK(!window.isPresentTimingEnabled());
+
+    return esd::wnd::test::result();
+}
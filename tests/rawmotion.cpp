@@ -0,0 +1,101 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#include "check.hpp"
+#include "impl.hpp"
+#include <X11/extensions/XTest.h>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+namespace {
+
+class TestWindow : public esd::wnd::Window {
+public:
+    using esd::wnd::Window::Window;
+
+    Display* getDisplay() { return impl->display; }
+    ::Window getXWindow() { return impl->window; }
+    bool isFocused() { return impl->focused; }
+};
+
+// Polls until done() holds, giving up after a couple of seconds
+template <typename F>
+bool pollUntil(TestWindow& window, F done) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        window.poll();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+}
+
+int main() {
+    if (!std::getenv("DISPLAY")) return esd::wnd::test::skipped;
+
+    TestWindow window("Raw Motion", { 320, 240 });
+    if (!window.isRawMotionSupported()) return esd::wnd::test::skipped;
+
+    Display* display = window.getDisplay();
+    int eventBase, errorBase, major, minor;
+    if (!XTestQueryExtension(display, &eventBase, &errorBase, &major, &minor)) 
+        return esd::wnd::test::skipped;
+
+    // Raw motion is only reported while focused, and there is no window
+    // manager under Xvfb to give the window focus
+    ESD_CHECK(pollUntil(window, [&] { return window.isVisible(); }));
+    XSetInputFocus(display, window.getXWindow(), RevertToParent, CurrentTime);
+    ESD_CHECK(pollUntil(window, [&] { return window.isFocused(); }));
+
+    std::size_t samples = 0;
+    double dx = 0, dy = 0;
+    window.setRawMotionHandler([&](esd::wnd::RawMotionEvent e) {
+        for (std::size_t i = 0; i < e.sampleCount; i++) {
+            dx += e.samples[i].dx;
+            dy += e.samples[i].dy;
+        }
+        samples += e.sampleCount;
+    });
+    window.setRawMotionEnabled(true);
+    XSync(display, False);
+
+    // Raw values are unaccelerated, so they add up to exactly what was sent
+    constexpr int motions = 50;
+    for (int i = 0; i < motions; i++) 
+        XTestFakeRelativeMotionEvent(display, 3, -2, CurrentTime);
+    XSync(display, False);
+
+    ESD_CHECK(pollUntil(window, [&] { return samples >= motions; }));
+
+    // Give duplicate reports from slave devices time to arrive
+    for (int i = 0; i < 50; i++) {
+        window.poll();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    ESD_CHECK_EQ(samples, static_cast<std::size_t>(motions));
+    ESD_CHECK_EQ(dx, 3.0 * motions);
+    ESD_CHECK_EQ(dy, -2.0 * motions);
+
+    return esd::wnd::test::result();
+}
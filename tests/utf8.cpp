@@ -0,0 +1,139 @@
+// Copyright (c) 2020 Elijah Seed Arita
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in 
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+
+#include "check.hpp"
+#include "simd.hpp"
+#include "utf8.hpp"
+#include <string>
+
+using namespace esd::wnd;
+
+namespace {
+
+// Decodes the whole text, checking how many bytes were valid
+std::u32string decode(std::string_view text, std::size_t valid) {
+    std::vector<char32_t> out = { U'>' };
+    ESD_CHECK_EQ(decodeUtf8(text, out), valid);
+
+    // Code points are appended after what's already there
+    ESD_CHECK_EQ(out.front(), U'>');
+    return std::u32string(out.begin() + 1, out.end());
+}
+
+std::string encode(char32_t codePoint) {
+    char out[4];
+    return std::string(out, encodeUtf8(codePoint, out));
+}
+
+}
+
+int main() {
+    // Every kernel the machine can run
+    for (Isa isa : { Isa::Scalar, Isa::Sse2, Isa::Avx2, Isa::Neon }) {
+        if (!setIsa(isa)) continue;
+
+        // ASCII runs shorter than, equal to and across the 16 byte blocks,
+        // ending in a multibyte sequence at every offset
+        for (std::size_t length = 0; length <= 40; length++) {
+            std::string text;
+            std::u32string expected;
+            for (std::size_t i = 0; i < length; i++) {
+                text += static_cast<char>('a' + i % 26);
+                expected += static_cast<char32_t>('a' + i % 26);
+            }
+            ESD_CHECK(decode(text, text.size()) == expected);
+
+            text += "\xC3\xA9";
+            expected += U'é';
+            ESD_CHECK(decode(text, text.size()) == expected);
+
+            // Invalid bytes after a run stop decoding right there
+            ESD_CHECK(decode(text.substr(0, length) + "\xFF" + "abc", length) == expected.substr(0, length));
+        }
+
+        // A non-ASCII byte late in a block falls back to decoding the block
+        // byte by byte
+        std::string mixed = std::string(15, 'x') + "\xE2\x82\xAC" + std::string(20, 'y');
+        ESD_CHECK(decode(mixed, mixed.size()) == std::u32string(15, U'x') + U'€' + std::u32string(20, U'y'));
+
+        // 2, 3 and 4 byte sequences at the ends of their ranges
+        ESD_CHECK(decode("\xC2\x80", 2) == U"\u0080");
+        ESD_CHECK(decode("\xDF\xBF", 2) == U"߿");
+        ESD_CHECK(decode("\xE0\xA0\x80", 3) == U"ࠀ");
+        ESD_CHECK(decode("\xED\x9F\xBF", 3) == U"퟿");
+        ESD_CHECK(decode("\xEE\x80\x80", 3) == U"");
+        ESD_CHECK(decode("\xEF\xBF\xBF", 3) == U"￿");
+        ESD_CHECK(decode("\xF0\x90\x80\x80", 4) == U"\U00010000");
+        ESD_CHECK(decode("\xF4\x8F\xBF\xBF", 4) == U"\U0010FFFF");
+        ESD_CHECK(decode("a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80z", 11) == U"aé€\U0001F600z");
+
+        // Overlong forms
+        ESD_CHECK(decode("\xC0\xAF", 0).empty());
+        ESD_CHECK(decode("\xC1\xBF", 0).empty());
+        ESD_CHECK(decode("\xE0\x9F\xBF", 0).empty());
+        ESD_CHECK(decode("\xF0\x8F\xBF\xBF", 0).empty());
+
+        // Surrogates
+        ESD_CHECK(decode("\xED\xA0\x80", 0).empty());
+        ESD_CHECK(decode("\xED\xBF\xBF", 0).empty());
+        ESD_CHECK(decode("ab\xED\xB0\x80", 2) == U"ab");
+
+        // Above U+10FFFF
+        ESD_CHECK(decode("\xF4\x90\x80\x80", 0).empty());
+        ESD_CHECK(decode("\xF5\x80\x80\x80", 0).empty());
+        ESD_CHECK(decode("\xF8\x88\x80\x80\x80", 0).empty());
+
+        // Truncated tails, and continuation bytes without a lead byte
+        ESD_CHECK(decode("ab\xC3", 2) == U"ab");
+        ESD_CHECK(decode("ab\xE2\x82", 2) == U"ab");
+        ESD_CHECK(decode("ab\xF0\x9F\x98", 2) == U"ab");
+        ESD_CHECK(decode("ab\xE2\x28\xA1", 2) == U"ab");
+        ESD_CHECK(decode("\x80", 0).empty());
+    }
+
+    ESD_CHECK(encode(U'A') == "A");
+    ESD_CHECK(encode(0x7F) == "\x7F");
+    ESD_CHECK(encode(0x80) == "\xC2\x80");
+    ESD_CHECK(encode(0x7FF) == "\xDF\xBF");
+    ESD_CHECK(encode(0x800) == "\xE0\xA0\x80");
+    ESD_CHECK(encode(0xD7FF) == "\xED\x9F\xBF");
+    ESD_CHECK(encode(0xE000) == "\xEE\x80\x80");
+    ESD_CHECK(encode(0xFFFF) == "\xEF\xBF\xBF");
+    ESD_CHECK(encode(0x10000) == "\xF0\x90\x80\x80");
+    ESD_CHECK(encode(0x10FFFF) == "\xF4\x8F\xBF\xBF");
+
+    // Surrogates and values past U+10FFFF can't be encoded
+    ESD_CHECK(encode(0xD800).empty());
+    ESD_CHECK(encode(0xDFFF).empty());
+    ESD_CHECK(encode(0x110000).empty());
+    ESD_CHECK(encode(0xFFFFFFFF).empty());
+
+    // Every valid code point survives a round trip
+    std::size_t roundTripFailures = 0;
+    for (char32_t codePoint = 0; codePoint <= 0x10FFFF; codePoint++) {
+        if (codePoint >= 0xD800 && codePoint <= 0xDFFF) continue;
+        std::string text = encode(codePoint);
+        std::vector<char32_t> out;
+        if (decodeUtf8(text, out) != text.size() || out.size() != 1 || out[0] != codePoint) roundTripFailures++;
+    }
+    ESD_CHECK_EQ(roundTripFailures, std::size_t(0));
+
+    return esd::wnd::test::result();
+}